@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BINARYIO_hpp
+#define BINARYIO_hpp
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+  * \brief Appends the bytes of v to b (native byte order)
+  */
+template<typename T> void putBinary(vector<char>& b, T v)
+{
+    const char* p=reinterpret_cast<const char*>(&v);
+    b.insert(b.end(), p, p+sizeof(T));
+}
+
+/**
+  * \brief Reads v from p and advances p, false if less than sizeof(T) bytes are left
+  */
+template<typename T> bool getBinary(const char*& p, const char* end, T& v)
+{
+    if(end-p<(long)sizeof(T))
+     return false;
+    memcpy(&v, p, sizeof(T));
+    p+=sizeof(T);
+    return true;
+}
+#endif //BINARYIO_hpp
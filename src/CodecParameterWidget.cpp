@@ -57,7 +57,7 @@ CodecParameterWidget::CodecParameterWidget()
     setLayout(vLayout);
 
     //set default values:
-    hardware->setChecked(true);
+    hardware->setChecked(false);
 
     bitrate->setMinimum(1000);
     bitrate->setMaximum(100000000);
@@ -78,8 +78,12 @@ CodecParameterWidget::CodecParameterWidget()
     codec->addItem(tr("H.264"));
     codec->addItem(tr("H.265"));
 
-    preset->addItem(tr("slow"));
-    preset->addItem(tr("fast"));
+    // x264/x265 speed presets, the GPU encoders use their own
+    const char* presets[]={"ultrafast", "superfast", "veryfast", "faster", "fast",
+                           "medium", "slow", "slower", "veryslow"};
+    for(int i=0; i<9; i++)
+        preset->addItem(presets[i]);
+    preset->setCurrentIndex(2);
 
     crf->setMinimum(1);
     crf->setMaximum(51);
@@ -124,6 +128,11 @@ int CodecParameterWidget::getPreset()
     return preset->currentIndex();
 }
 
+QString CodecParameterWidget::getPresetName()
+{
+    return preset->currentText();
+}
+
 void CodecParameterWidget::setHardware(bool b)
 {
     hardware->setChecked(b);
@@ -58,6 +58,7 @@ public slots:
     int getFrameDen();
     int getCodec();
     int getPreset();
+    QString getPresetName();
     bool getUseCrf();
     int getCrf();
         
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "DetectionCounts.hpp"
+
+using namespace std;
+
+DetectionCounts::DetectionCounts()
+{
+}
+
+void DetectionCounts::reset(unsigned long n)
+{
+    vector<long>(n,0).swap(tree);
+}
+
+void DetectionCounts::push_back(long count)
+{
+    // the new node covers the frames (i-lowbit(i+1), i]
+    unsigned long i=tree.size();
+    unsigned long low=(i+1)&(~i);
+    tree.push_back(count+prefix(i)-prefix(i+1-low));
+}
+
+void DetectionCounts::add(unsigned long i, long delta)
+{
+    for(i++; i<=tree.size(); i+=i&(~i+1))
+     tree[i-1]+=delta;
+}
+
+long DetectionCounts::prefix(unsigned long i)
+{
+    // sum of the frames [0, i)
+    long s=0;
+    if(i>tree.size()) i=tree.size();
+    for(; i>0; i-=i&(~i+1))
+     s+=tree[i-1];
+    return s;
+}
+
+long DetectionCounts::range(unsigned long n, unsigned long m)
+{
+    if(m<=n)
+     return 0;
+    return prefix(m)-prefix(n);
+}
+
+vector<long> DetectionCounts::timeline(unsigned long n, unsigned long m, unsigned long bins)
+{
+    // positions in bins of equal width between the frames n and m
+    vector<long> t;
+    if(m>tree.size()) m=tree.size();
+    if(m<=n || bins==0)
+     return t;
+    if(bins>m-n) bins=m-n;
+    t.resize(bins);
+    long last=prefix(n);
+    for(unsigned long b=0; b<bins; b++)
+    {
+     unsigned long e=n+(m-n)*(b+1)/bins;
+     long p=prefix(e);
+     t[b]=p-last;
+     last=p;
+    }
+    return t;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DETECTIONCOUNTS_hpp
+#define DETECTIONCOUNTS_hpp
+#include <vector>
+
+using namespace std;
+
+/**
+  * \brief Number of positions per frame as a Fenwick tree
+  *
+  * Counts of single frames are updated by the frames themselves while they are
+  * edited, the number of positions in any range of frames is available in
+  * O(log n) without touching the frames. Frames are given by their index into
+  * the frames of the MosquitoesInSeq.
+  */
+class DetectionCounts
+{
+public:
+    DetectionCounts();
+    void reset(unsigned long n);
+    void push_back(long count);
+    void add(unsigned long i, long delta);
+    long prefix(unsigned long i);
+    long range(unsigned long n, unsigned long m);
+    long at(unsigned long i){return range(i,i+1);};
+    long total(){return prefix(tree.size());};
+    unsigned long size(){return tree.size();};
+    vector<long> timeline(unsigned long n, unsigned long m, unsigned long bins);
+private:
+    // tree[i] holds the sum of the frames (i-lowbit(i+1), i]
+    vector<long> tree;
+};
+#endif //DETECTIONCOUNTS_hpp
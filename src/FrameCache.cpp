@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FrameCache.hpp"
+#include <string.h>
+
+using namespace std;
+
+FrameCache::FrameCache()
+{
+    budgetMB=0;
+    budget=0;
+    used=0;
+}
+
+void FrameCache::setBudget(unsigned long MB)
+{
+    lock_guard<mutex> l(lock);
+    budgetMB=MB;
+    budget=(size_t)MB*1024*1024;
+    evict(0);
+}
+
+void FrameCache::clear()
+{
+    lock_guard<mutex> l(lock);
+    frames.clear();
+    index.clear();
+    vector<unsigned char>().swap(spare);
+    used=0;
+}
+
+bool FrameCache::has(int64_t n)
+{
+    lock_guard<mutex> l(lock);
+    return index.find(n)!=index.end();
+}
+
+bool FrameCache::get(int64_t n, unsigned char* dst, size_t size)
+{
+    lock_guard<mutex> l(lock);
+    map<int64_t, list<cachedFrame>::iterator>::iterator it=index.find(n);
+    if(it==index.end() || it->second->data.size()!=size)
+     return false;
+    memcpy(dst, it->second->data.data(), size);
+    frames.splice(frames.begin(), frames, it->second);
+    return true;
+}
+
+void FrameCache::put(int64_t n, const unsigned char* src, int linesize, int w, int h)
+{
+    size_t size=(size_t)w*h;
+    lock_guard<mutex> l(lock);
+    if(size==0 || size>budget)
+     return;
+    map<int64_t, list<cachedFrame>::iterator>::iterator it=index.find(n);
+    if(it!=index.end())
+    {
+     frames.splice(frames.begin(), frames, it->second);
+     return;
+    }
+    evict(size);
+    frames.push_front(cachedFrame());
+    cachedFrame& f=frames.front();
+    f.n=n;
+    // the buffer of the frame dropped last is reused
+    f.data.swap(spare);
+    f.data.resize(size);
+    if(linesize==w)
+     memcpy(f.data.data(), src, size);
+    else
+     for(int y=0; y<h; y++)
+      memcpy(f.data.data()+(size_t)y*w, src+(size_t)y*linesize, w);
+    index[n]=frames.begin();
+    used+=size;
+}
+
+void FrameCache::evict(size_t need)
+{
+    // drops the least recently used frames until need more bytes fit
+    while(!frames.empty() && used+need>budget)
+    {
+     cachedFrame& f=frames.back();
+     used-=f.data.size();
+     index.erase(f.n);
+     spare.swap(f.data);
+     frames.pop_back();
+    }
+}
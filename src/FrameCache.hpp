@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FRAMECACHE_hpp
+#define FRAMECACHE_hpp
+#include <vector>
+#include <list>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <stddef.h>
+
+using namespace std;
+
+/**
+  * \brief Most recently decoded frames of a video within a memory budget
+  *
+  * Keeps the luma planes of decoded frames by frame number. Once the frames
+  * exceed the budget, the least recently used ones are dropped. The cache is
+  * filled and read from different threads. With a budget of 0 nothing is kept.
+  */
+class FrameCache
+{
+public:
+    FrameCache();
+    void setBudget(unsigned long MB);
+    unsigned long getBudget(){return budgetMB;};
+    void clear();
+    bool has(int64_t n);
+    bool get(int64_t n, unsigned char* dst, size_t size);
+    void put(int64_t n, const unsigned char* src, int linesize, int w, int h);
+private:
+    struct cachedFrame {
+        int64_t n;
+        vector<unsigned char> data;
+    };
+    void evict(size_t need);
+    list<cachedFrame> frames;
+    map<int64_t, list<cachedFrame>::iterator> index;
+    vector<unsigned char> spare;
+    unsigned long budgetMB;
+    size_t budget;
+    size_t used;
+    mutex lock;
+};
+#endif //FRAMECACHE_hpp
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <vector>
 #include "Header.hpp"
+#include "BinaryIO.hpp"
 #include "unicode/utypes.h"
 #include "unicode/ucnv.h"
 #include "unicode/ustring.h"
@@ -88,35 +89,29 @@ int Header::ReadHeader(fstream *seqFile)
 {
     if(seqFile)
     {
+        // the header is read in one piece and parsed from memory
+        char buffer[SEQHEADERREADSIZE];
         seqFile->seekg (0, seqFile->beg);
-        seqFile->read(reinterpret_cast<char*>(&Magic), sizeof(unsigned int));
-        if(Magic!=65261)
+        seqFile->read(buffer, SEQHEADERREADSIZE);
+        const char* p=buffer;
+        const char* end=buffer+seqFile->gcount();
+        seqFile->clear();
+        if(!getBinary(p,end,Magic) || Magic!=65261)
          return 1;    
-        seqFile->read(reinterpret_cast<char*>(&Name), 24*sizeof(char));
-        seqFile->read(reinterpret_cast<char*>(&Version), sizeof(int));
-        seqFile->read(reinterpret_cast<char*>(&HeaderSize), sizeof(int));
-        seqFile->read(reinterpret_cast<char*>(&Description), sizeof(char)*512);
-        seqFile->read(reinterpret_cast<char*>(&Width), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Height), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Depth), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&RealDepth), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&ImageBSize), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&ImageFormat), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&AllocatedFrames), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Origin), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&TrueImageSize), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Framerate), sizeof(double));
-        seqFile->read(reinterpret_cast<char*>(&DescriptionFormat), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&ReferenceFrame), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&FixedSize), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Flags), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&BayerPattern), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Time_offset_us), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&ExtendedHeaderSize), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Compression_format), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Reference_time_s), sizeof(unsigned int));
-        seqFile->read(reinterpret_cast<char*>(&Reference_time_ms), sizeof(unsigned short));
-        seqFile->read(reinterpret_cast<char*>(&Reference_time_us), sizeof(unsigned short));
+        bool ok=getBinary(p,end,Name) && getBinary(p,end,Version) && getBinary(p,end,HeaderSize) &&
+                getBinary(p,end,Description) && getBinary(p,end,Width) && getBinary(p,end,Height) &&
+                getBinary(p,end,Depth) && getBinary(p,end,RealDepth) && getBinary(p,end,ImageBSize) &&
+                getBinary(p,end,ImageFormat) && getBinary(p,end,AllocatedFrames) && getBinary(p,end,Origin) &&
+                getBinary(p,end,TrueImageSize) && getBinary(p,end,Framerate) && getBinary(p,end,DescriptionFormat) &&
+                getBinary(p,end,ReferenceFrame) && getBinary(p,end,FixedSize) && getBinary(p,end,Flags) &&
+                getBinary(p,end,BayerPattern) && getBinary(p,end,Time_offset_us) && getBinary(p,end,ExtendedHeaderSize) &&
+                getBinary(p,end,Compression_format) && getBinary(p,end,Reference_time_s) &&
+                getBinary(p,end,Reference_time_ms) && getBinary(p,end,Reference_time_us);
+        if(!ok)
+        {
+         cerr<<"The header of the seq file is incomplete\n";
+         return 1;
+        }
         ReadOnly=1;
         if(Version>=5)
         {
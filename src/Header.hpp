@@ -29,6 +29,9 @@
 #include <sstream>
 #include <vector>
 
+// bytes read at once when a header is opened, all fields are within them
+#define SEQHEADERREADSIZE 1024
+
 using namespace std;
 
 /** \brief Header Class for the access to *.seq files
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "KeyframeIndex.hpp"
+#include "Sidecar.hpp"
+#include "BinaryIO.hpp"
+#include <string.h>
+#include <deque>
+#include <mutex>
+
+using namespace std;
+
+/**
+  * \brief Index remembered for a video, valid while the video is unchanged
+  */
+struct rememberedIndex {
+    string source;
+    uint64_t size;
+    int64_t mtime;
+    KeyframeIndex index;
+};
+
+static deque<rememberedIndex> remembered;
+static mutex rememberedMutex;
+
+KeyframeIndex::KeyframeIndex()
+{
+}
+
+void KeyframeIndex::clear()
+{
+    vector<int64_t>().swap(pts);
+    vector<int64_t>().swap(pos);
+    vector<unsigned char>().swap(key);
+    vector<long>().swap(packet);
+}
+
+void KeyframeIndex::add(int64_t _pts, int64_t _pos, bool _key)
+{
+    pts.push_back(_pts);
+    pos.push_back(_pos);
+    key.push_back(_key?1:0);
+}
+
+void KeyframeIndex::setFrames(const vector<int64_t>& frameOfPacket)
+{
+    // frames are in display order, packets in decoding order
+    packet.clear();
+    for(unsigned long p=0; p<frameOfPacket.size() && p<pts.size(); p++)
+    {
+     int64_t f=frameOfPacket[p];
+     if(f<0)
+      continue;
+     if((unsigned long)f>=packet.size())
+      packet.resize(f+1,-1);
+     if(packet[f]<0)
+      packet[f]=p;
+    }
+}
+
+long KeyframeIndex::packetOf(int64_t frame)
+{
+    if(frame<0 || (unsigned long)frame>=packet.size())
+     return -1;
+    return packet[frame];
+}
+
+long KeyframeIndex::keyBefore(long p)
+{
+    // last keyframe at or before packet p, or -1
+    if(p>=(long)key.size())
+     return -1;
+    for(; p>=0; p--)
+     if(key[p])
+      return p;
+    return -1;
+}
+
+bool KeyframeIndex::save(string filename, string source)
+{
+    vector<char> b;
+    putBinary<uint64_t>(b, pts.size());
+    unsigned long head=b.size();
+    b.resize(head+pts.size()*(2*sizeof(int64_t)+1));
+    if(pts.size()>0)
+    {
+     memcpy(b.data()+head, pts.data(), pts.size()*sizeof(int64_t));
+     memcpy(b.data()+head+pts.size()*sizeof(int64_t), pos.data(), pos.size()*sizeof(int64_t));
+     memcpy(b.data()+head+2*pts.size()*sizeof(int64_t), key.data(), key.size());
+    }
+    return Sidecar::save(filename, source, KEYFRAMEINDEXMAGIC, KEYFRAMEINDEXVERSION, b);
+}
+
+bool KeyframeIndex::load(string filename, string source)
+{
+    vector<char> b;
+    if(!Sidecar::load(filename, source, KEYFRAMEINDEXMAGIC, KEYFRAMEINDEXVERSION, b))
+     return false;
+    const char* p=b.data();
+    const char* end=b.data()+b.size();
+    uint64_t packets;
+    if(!getBinary(p,end,packets))
+     return false;
+    if((unsigned long)(end-p)!=packets*(2*sizeof(int64_t)+1))
+     return false;
+    clear();
+    pts.resize(packets);
+    pos.resize(packets);
+    key.resize(packets);
+    if(packets>0)
+    {
+     memcpy(pts.data(), p, packets*sizeof(int64_t));
+     memcpy(pos.data(), p+packets*sizeof(int64_t), packets*sizeof(int64_t));
+     memcpy(key.data(), p+2*packets*sizeof(int64_t), packets);
+    }
+    return true;
+}
+
+bool KeyframeIndex::recall(string source)
+{
+    uint64_t size;
+    int64_t mtime;
+    if(!Sidecar::sourceStamp(source, size, mtime))
+     return false;
+    lock_guard<mutex> lock(rememberedMutex);
+    for(unsigned long i=0; i<remembered.size(); i++)
+     if(remembered[i].source==source && remembered[i].size==size && remembered[i].mtime==mtime)
+     {
+      pts=remembered[i].index.pts;
+      pos=remembered[i].index.pos;
+      key=remembered[i].index.key;
+      packet.clear();
+      return true;
+     }
+    return false;
+}
+
+void KeyframeIndex::remember(string source)
+{
+    rememberedIndex r;
+    if(!Sidecar::sourceStamp(source, r.size, r.mtime))
+     return;
+    r.source=source;
+    r.index.pts=pts;
+    r.index.pos=pos;
+    r.index.key=key;
+    lock_guard<mutex> lock(rememberedMutex);
+    for(unsigned long i=0; i<remembered.size(); i++)
+     if(remembered[i].source==source)
+     {
+      remembered.erase(remembered.begin()+i);
+      break;
+     }
+    remembered.push_back(r);
+    while(remembered.size()>KEYFRAMEINDEXREMEMBER)
+     remembered.pop_front();
+}
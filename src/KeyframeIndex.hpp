@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef KEYFRAMEINDEX_hpp
+#define KEYFRAMEINDEX_hpp
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// "KFI1" at the start of every keyframe index sidecar
+#define KEYFRAMEINDEXMAGIC 0x3149464B
+#define KEYFRAMEINDEXVERSION 1
+// indexes kept in memory for the readers of this process, also when the sidecar can't be written
+#define KEYFRAMEINDEXREMEMBER 16
+
+using namespace std;
+
+/**
+  * \brief Video packets of a video stream in decoding order
+  *
+  * Every packet takes its time stamp, the byte offset in the file and
+  * whether it starts a keyframe. The index is stored next to the video,
+  * together with the size and modification time of the video, so the
+  * video only has to be scanned once. The last indexes are also remembered
+  * in memory, so further readers of the same video (e.g. for the preview)
+  * do not scan it again when the sidecar could not be written.
+  */
+class KeyframeIndex
+{
+public:
+    KeyframeIndex();
+    void clear();
+    void add(int64_t pts, int64_t pos, bool key);
+    unsigned long size(){return pts.size();};
+    bool empty(){return pts.empty();};
+    int64_t ptsOf(unsigned long p){return pts[p];};
+    int64_t posOf(unsigned long p){return pos[p];};
+    bool isKey(unsigned long p){return key[p]!=0;};
+    void setFrames(const vector<int64_t>& frameOfPacket);
+    long packetOf(int64_t frame);
+    long keyBefore(long packet);
+    bool save(string filename, string source);
+    bool load(string filename, string source);
+    bool recall(string source);
+    void remember(string source);
+private:
+    vector<int64_t> pts;
+    vector<int64_t> pos;
+    vector<unsigned char> key;
+    // packet that holds a frame, -1 for frames without packet
+    vector<long> packet;
+};
+#endif //KEYFRAMEINDEX_hpp
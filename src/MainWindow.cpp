@@ -101,8 +101,7 @@ MainWindow::MainWindow()
     ith_changed=1;
     debug=0;
     process_all=0;
-    maxHistSize=2;
-    lastMosqPosHist=-1;
+    maxHistSize=50;
     lastRegHist=-1;
     disablePosBackup=true;
     m_player=new VideoPlayerWidget();
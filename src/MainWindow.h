@@ -196,6 +196,7 @@ private:
     bool backupPos(unsigned int n, bool force = false);
     bool backupTracks(unsigned int n);
     bool restorePos(unsigned int n);
+    bool redoPos(unsigned int n);
     bool restoreTracks(unsigned int n);
     int seqPointerToSeqNum(iSeq* sp);
     void updatePointerOfTracks(int c, int r);
@@ -263,10 +264,8 @@ private:
     SegmentationWorker* worker;
     int ith_changed;
     std::vector<MosquitoesInSeq> MosqPos;
-    std::vector<std::vector<MosquitoesInSeq> > MosqPosHist;
-    int lastMosqPosHist;
     std::vector<MosquitoRegistry> Reg;
-    std::vector<std::vector<MosquitoRegistry> > RegHist;
+    std::vector<std::vector<registrySnapshot> > RegHist;
     int lastRegHist;
     unsigned long maxHistSize;
     MosquitoesInSeq *currMosqPos;
@@ -343,6 +342,10 @@ private slots:
     void on_actionCleanCluster_triggered();
     void on_actionCleanAllCluster_triggered();
     void on_actionResetPositions_triggered();
+    void on_actionMemoryBudget_triggered();
+    void on_actionVideoDecoding_triggered();
+    void on_actionIngestVideo_triggered();
+    void on_actionShowTimeline_triggered();
     void on_actionResetTracks_triggered();
     void on_blackOnWhite_checked(int i);
     void on_displayShowPointsClicked(int i);
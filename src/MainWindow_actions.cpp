@@ -31,6 +31,7 @@
 #include "MosquitoesInSeq.hpp"
 #include "MosquitoPosition.hpp"
 #include "iSeq.hpp"
+#include "VideoIngest.hpp"
 #include "DisplaySettingsParameterWidget.h"
 #include "ImageComposer.hpp"
 #include <QApplication>
@@ -137,7 +138,6 @@ void MainWindow::on_actionClose_triggered()
         MosqPos.erase (MosqPos.begin()+toRemove);
         Reg.erase (Reg.begin()+toRemove);
         RegHist.erase (RegHist.begin()+toRemove);
-        MosqPosHist.erase (MosqPosHist.begin()+toRemove);
         settings.erase (settings.begin()+toRemove);
         seqFileChanged=true;
         seqInfo->removeFromList(toRemove);
@@ -483,6 +483,74 @@ void MainWindow::on_actionResetPositions_triggered()
   currSeq->setPosfilename(string());
 }
 
+void MainWindow::on_actionMemoryBudget_triggered()
+{
+  bool ok=false;
+  int x = QInputDialog::getInt(this, tr("QInputDialog::getInt()"),
+                                    tr("Memory for positions in MB (0 = unlimited):"), currMosqPos->getMemoryBudget(), 0, 1000000, 64, &ok);
+  if(ok)
+  {
+   if(!currMosqPos->setMemoryBudget(x, currSeq->pageName()))
+    cerr<<"Could not set a memory budget of "<<x<<" MB for the positions\n";
+   saveSettingsToFile(currSeq->settingsName());
+  }
+}
+
+void MainWindow::on_actionVideoDecoding_triggered()
+{
+  bool ok=false;
+  int threads = QInputDialog::getInt(this, tr("QInputDialog::getInt()"),
+                                    tr("Decoder threads for videos (0 = one per core):"), currSeq->getVideoThreads(), 0, 256, 1, &ok);
+  if(!ok)
+   return;
+  int ahead = QInputDialog::getInt(this, tr("QInputDialog::getInt()"),
+                                    tr("Frames decoded ahead (0 = decode on demand):"), currSeq->getVideoDecodeAhead(), 0, 1024, 1, &ok);
+  if(!ok)
+   return;
+  int cacheMB = QInputDialog::getInt(this, tr("QInputDialog::getInt()"),
+                                    tr("Memory for decoded frames in MB (0 = no cache):"), currSeq->getVideoCache(), 0, 1000000, 64, &ok);
+  if(ok)
+  {
+   currSeq->setVideoDecoding(threads, currSeq->getVideoThreadType(), ahead);
+   currSeq->setVideoCache(cacheMB);
+   saveSettingsToFile(currSeq->settingsName());
+  }
+}
+
+void MainWindow::on_actionIngestVideo_triggered()
+{
+  // the video is decoded once more into a raw copy, which is read the next time it is opened
+  if(!currSeq->isVideo() && !currSeq->isIngested())
+  {
+   cerr<<currSeq->filename()<<" is not a video\n";
+   return;
+  }
+  QProgressDialog* DisplayProgress;
+  DisplayProgress=new QProgressDialog("Ingesting Video...", "Cancel", 0, currSeq->allocatedFrames(), this);
+  DisplayProgress->setWindowModality(Qt::WindowModal);
+  int ret=VideoIngest::ingest(currSeq->filename(),[DisplayProgress](unsigned long done, unsigned long n){
+    if(done%100==0 || done==n)
+     DisplayProgress->setValue(done);
+    return !DisplayProgress->wasCanceled();
+  });
+  DisplayProgress->setValue(currSeq->allocatedFrames());
+  delete DisplayProgress;
+  if(ret!=0)
+   cerr<<"Could not ingest "<<currSeq->filename()<<"\n";
+}
+
+void MainWindow::on_actionShowTimeline_triggered()
+{
+  // positions per bin over the whole sequence, the bins come from the prefix sums
+  unsigned long n=currSeq->allocatedFrames();
+  vector<long> t=currMosqPos->getActivityTimeline(0,n,1000);
+  vector<QPointF> data;
+  for(unsigned long i=0; i<t.size(); i++)
+   data.push_back(QPointF((i+0.5)*n/t.size(),t[i]));
+  Graph->setData(data);
+  GraphDock->show();
+}
+
 void MainWindow::on_actionResetTracks_triggered()
 {
   currReg->reset();
@@ -728,7 +796,8 @@ if(seq.size()>0)
     int numTasks = toFrame-fromFrame+1 ;
     DisplayProgress=new QProgressDialog("Processing Sequence...", "Cancel", 0, numTasks, this);
     DisplayProgress->setWindowModality(Qt::WindowModal);
-    backupPos(currSeqNum);
+    // a whole run would be one undo step holding every detected position
+    currMosqPos->setJournaling(false);
     timerID2=startTimer(0);
 }
 }
@@ -796,6 +865,7 @@ if(!appendTracks)
   currReg->reset();
   
 MosquitoesInSeq tmpP=*currMosqPos;
+bool registryFull=false;
 
 DisplayProgress=new QProgressDialog("Tracking Sequence...", "Cancel", 0, tmpP.getNoOfFrames(), this);
 DisplayProgress->setWindowModality(Qt::WindowModal);
@@ -840,6 +910,11 @@ for(unsigned long ii=0; ii<n;ii++)
  if(ids[ii]==-1)
  {
   ids[ii]=currReg->registerNewMosquito();
+  if(ids[ii]==-1)
+  {
+   registryFull=true;
+   break;
+  }
   starts++;
  }
   
@@ -848,6 +923,8 @@ for(unsigned long ii=0; ii<n;ii++)
  currReg->updateTrack(ids[ii],NewTrackPoint);
  added++;
 }
+if(registryFull)
+ break;
 
 if(trigger2!=trigger+1)
 {
@@ -1004,6 +1081,12 @@ for(int jj=0;jj<m;jj++)
 }
     DisplayProgress->setValue(tmpP.getNoOfFrames());
     delete DisplayProgress;
+    if(registryFull)
+    {
+     QMessageBox msgBox;
+     msgBox.setText(QString("Error: the registry is full, tracking stopped before the end of the sequence!"));
+     msgBox.exec();
+    }
     m_player->showImageWithPoints(m_player->getCurrentFrameNo());
 }
 if(showAllPoints)
@@ -1454,7 +1537,7 @@ void MainWindow::on_tTable_ContextMenuRequest(const QPoint & P)
         {
          for(int n=0; n<toDisplay.size(); n++)
          {
-          vector<vector<double> > a=currReg->trackStatistics(currReg->getVectorOfTrackPoints(toDisplay[n]));
+          vector<vector<double> > a=currReg->trackStatistics(toDisplay[n]);
           if(a.size()==0)
           {
            cerr<<toDisplay[n]<<" can't caluclate statistics\n";
@@ -1501,7 +1584,7 @@ void MainWindow::on_tTable_ContextMenuRequest(const QPoint & P)
       }
       else
       {
-          vector<vector<double> > a=currReg->trackStatistics(currReg->getVectorOfTrackPoints(tmpI));
+          vector<vector<double> > a=currReg->trackStatistics(tmpI);
           if(a.size()==0)
           {
            cerr<<tmpI<<" can't caluclate statistics\n";
@@ -1698,7 +1781,7 @@ void MainWindow::processSeqI(unsigned long i)
     int numTasks = toFrame-fromFrame+1 ;
     DisplayProgress=new QProgressDialog("Processing Sequence...", "Cancel", 0, numTasks, this);
     DisplayProgress->setWindowModality(Qt::WindowModal);
-
+    currMosqPos->setJournaling(false);
     timerID2=startTimer(0);
     }
 }
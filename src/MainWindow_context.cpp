@@ -119,6 +119,19 @@ void MainWindow::showContextMenuClicked(QPoint m, int c, int r)
          }
       }
   });
+  displayMode-> addAction(tr("Redo Position"), this,[this,c,r](){
+      if(seq.size()>0)
+      {
+         int sqn=seqPointerToSeqNum(m_player->getSeqPointer(c,r));
+         if(sqn!=-1)
+         {
+          redoPos(sqn);
+          m_player->showImageWithPoints(m_player->getCurrentFrameNo());
+          if(showAllPoints)
+           m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
+         }
+      }
+  });
   displayMode-> addAction(tr("Undo Tracks"), this,[this,c,r](){
       if(seq.size()>0)
       {
@@ -142,6 +155,17 @@ void MainWindow::showContextMenuClicked(QPoint m, int c, int r)
       }
   });
 
+  displayMode-> addAction(tr("Preview Decoding"), this,[this,c,r](){
+      if(m_player->getSeqPointer(c,r))
+      {
+       bool ok=false;
+       int x = QInputDialog::getInt(this, tr("QInputDialog::getInt()"),
+                                         tr("Shrink frames while playing by (1 = full frames):"), m_player->getPreview(c,r)>1?m_player->getPreview(c,r):PLAYERPREVIEWFACTOR, 1, 16, 1, &ok);
+       if(ok)
+        m_player->setPreview(c,r,x);
+      }
+  });
+
   displayMode-> addAction(tr("Display difference Image"), this,[this,c,r](){
       if(seq.size()>0)
       { 
@@ -537,7 +561,7 @@ void MainWindow::showContextMenuClicked(QPoint m, int c, int r)
      if(m_player->getMosqPointer(c,r))
       if(m_player->getTrackPointer(c,r))
     {
-     m_player->getTrackPointer(c,r)->markMosquitoesToKeep();
+     m_player->getTrackPointer(c,r)->markMosquitoesToKeep(m_player->getMosqPointer(c,r));
      backupPos(seqPointerToSeqNum(m_player->getSeqPointer(c,r)));
      m_player->getMosqPointer(c,r)->removeMarkedMosquitoes(frameSelect->getFrom(),frameSelect->getTo(),m_player->useMetaMode());
     }
@@ -549,12 +573,13 @@ void MainWindow::showContextMenuClicked(QPoint m, int c, int r)
       if(m_player->getTrackPointer(c,r))
     {
     backupPos(seqPointerToSeqNum(m_player->getSeqPointer(c,r)));
-    for(int q=0; q<m_player->getTrackPointer(c,r)->numOfTracks(); q++)
+    vector<int> ids=m_player->getTrackPointer(c,r)->trackIDs();
+    for(int q=0; q<ids.size(); q++)
     { 
     double ox;
     double oy;
     unsigned long of;
-    vector<vector<TrackPoint> > pieces=m_player->getTrackPointer(c,r)->getMissingPieces(q);
+    vector<vector<TrackPoint> > pieces=m_player->getTrackPointer(c,r)->getMissingPieces(ids[q]);
     if(pieces.size()>0)
     {
      cerr<<"I need to loop over "<< pieces.size() << "missing pieces...\n";
@@ -641,7 +666,7 @@ void MainWindow::showContextMenuClicked(QPoint m, int c, int r)
           {
            TrackPoint NewTrackPoint(cM->getX(),cM->getY(),tmp[0],cF->getTsSec(),cF->getTsMSec(),cF->getTsUSec(),
                             cM->getI(),cM->getA(),cF->getMaxDiff(),cF->getMinArea(),cF->getMaxArea(),
-                            cF->getThreshold(),cF->getMinThreshold(),cF->getIth());
+                            cF->getThreshold(),cF->getMinThreshold(),cF->getIth(),cM->getSlot());
            m_player->getTrackPointer(c,r)->addPointToTrack(q, NewTrackPoint);
            updatePointerOfTracks(c,r);
            pieces[p][0]=NewTrackPoint;
@@ -827,7 +852,7 @@ void MainWindow::showContextMenuClicked(QPoint m, int c, int r)
      {
          int rem=m_player->getTrackPointer(c,r)->removeTooShort(x); 
          cerr<<"I have removed "<<rem<<" too short tracks...\n";
-         m_player->getTrackPointer(c,r)->updateMosquitoPointer(m_player->getMosqPointer(c,r));
+         m_player->getTrackPointer(c,r)->linkPositions(m_player->getMosqPointer(c,r));
      }
      else
      {
@@ -99,7 +99,7 @@ void MainWindow::updatePointerOfTracks(int c, int r)
  if(seq.size()>0)
  if(m_player->getSeqPointer(c,r) && m_player->getTrackPointer(c,r) && m_player->getMosqPointer(c,r))
  {
-  m_player->getTrackPointer(c,r)->updateMosquitoPointer(m_player->getMosqPointer(c,r));
+  m_player->getTrackPointer(c,r)->linkPositions(m_player->getMosqPointer(c,r));
  }
 }
 
@@ -111,20 +111,9 @@ bool MainWindow::backupPos(unsigned int n, bool force /*=false*/)
   cerr<<"I want to backup..\n";
  if(n<MosqPos.size() && (disablePosBackup || force))
  {
-  MosquitoesInSeq tmp;
-  MosqPos[n].copyTo(tmp);
-  MosqPosHist[n].push_back(tmp);
-  cerr<<"Have added Positions to backup.\nNow I have "<< MosqPosHist[n].size()<< " backups for " << n<<"\n";
-  for(unsigned int i=0; i<MosqPosHist[n].size(); i++)
-   cerr<<"backup ["<<i<<"] contains "<<MosqPosHist[n][i].getNumOfAllPos()<<" Mosquitoes\n";
-  if(MosqPosHist[n].size()>maxHistSize)
-  {
-   unsigned int N=MosqPosHist[n].size()-maxHistSize;
-   vector<MosquitoesInSeq> tmp(MosqPosHist[n].begin() + N, MosqPosHist[n].begin()+MosqPosHist[n].size());
-   MosqPosHist[n].swap(tmp);
-   cerr<<"Reduced backup size to "<< MosqPosHist[n].size()<< " backups for " << n<<"\n"; 
-  }
-  
+  // the positions only journal the edits following this call
+  MosqPos[n].beginUndoStep(maxHistSize);
+  cerr<<"Started new undo step for the positions of " << n<<"\n";
   return true;
  }
  else
@@ -137,17 +126,13 @@ bool MainWindow::backupTracks(unsigned int n)
 {
  if(n<Reg.size())
  {
-  MosquitoRegistry tmp;
-  Reg[n].copyTo(tmp);
-  RegHist[n].push_back(tmp);
+  // snapshots share all tracks which did not change since the previous backup
+  RegHist[n].push_back(Reg[n].snapshot());
   cerr<<"Have added Tracks to backup.\nNow I have "<< RegHist[n].size()<< " backups for " << n<<"\n";
-  for(unsigned int i=0; i<RegHist[n].size(); i++)
-   cerr<<"backup ["<<i<<"] contains "<<RegHist[n][i].numOfTracks()<<" Tracks\n";
   if(RegHist[n].size()>maxHistSize)
   {
    unsigned int N=RegHist[n].size()-maxHistSize;
-   vector<MosquitoRegistry> tmp(RegHist[n].begin() + N, RegHist[n].begin()+RegHist[n].size());
-   RegHist[n].swap(tmp);
+   RegHist[n].erase(RegHist[n].begin(), RegHist[n].begin() + N);
    cerr<<"Reduced backup size to "<< RegHist[n].size()<< " backups for " << n<<"\n"; 
   }
   return true;
@@ -160,17 +145,26 @@ bool MainWindow::restorePos(unsigned int n)
 {
  if(n<MosqPos.size())
  {
-  if(MosqPosHist[n].size()>0)
-  {
-   MosquitoesInSeq tmp=MosqPosHist[n].back();
-   tmp.copyTo(MosqPos[n]);
-   MosqPosHist[n].pop_back();
+  if(MosqPos[n].undo())
    return true;
-  }
+  if(MosqPos[n].canUndo())
+   cerr<<"Could not undo the last change of the positions!\n";
+  else
+   cerr<<"I don't have any backups left!\n";
  }
- else
+ return false;
+}
+
+bool MainWindow::redoPos(unsigned int n)
+{
+ if(n<MosqPos.size())
  {
-  cerr<<"I don't have any backups left!\n";
+  if(MosqPos[n].redo())
+   return true;
+  if(MosqPos[n].canRedo())
+   cerr<<"Could not redo the last change of the positions!\n";
+  else
+   cerr<<"Nothing to redo!\n";
  }
  return false;
 }
@@ -181,8 +175,7 @@ bool MainWindow::restoreTracks(unsigned int n)
  {
   if(RegHist[n].size()>0)
   {
-   MosquitoRegistry tmp=Reg[n] = RegHist[n].back();
-   tmp.copyTo(Reg[n]);
+   Reg[n].restore(RegHist[n].back());
    RegHist[n].pop_back();
    return true;
   }
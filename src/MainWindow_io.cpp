@@ -31,6 +31,7 @@
 #include "MosquitoesInSeq.hpp"
 #include "MosquitoPosition.hpp"
 #include "iSeq.hpp"
+#include "PositionBackup.hpp"
 #include "DisplaySettingsParameterWidget.h"
 #include "ImageComposer.hpp"
 #include <QApplication>
@@ -90,9 +91,7 @@ bool MainWindow::loadFile(const QString &fileName)
     seq.push_back(iSeq());
     MosqPos.push_back(MosquitoesInSeq());
     Reg.push_back(MosquitoRegistry());
-    vector<MosquitoesInSeq> tmp;
-    MosqPosHist.push_back(tmp);
-    vector<MosquitoRegistry> tmp2;
+    vector<registrySnapshot> tmp2;
     RegHist.push_back(tmp2);
     settings.push_back(defSettings);
     unsigned long lastCurrMosqPos=currSeqNum;
@@ -110,7 +109,6 @@ bool MainWindow::loadFile(const QString &fileName)
       MosqPos.pop_back();
       Reg.pop_back();
       RegHist.pop_back();
-      MosqPosHist.pop_back();  
       settings.pop_back();
       currSeq=nullptr;
       currMosqPos=nullptr;
@@ -186,7 +184,19 @@ bool MainWindow::loadFile(const QString &fileName)
         msgBox.addButton(QMessageBox::No);
         msgBox.setDefaultButton(QMessageBox::No);
         if(msgBox.exec() == QMessageBox::Yes){
-            fromFrame=currMosqPos->loadFromFile(bname,false,true);
+            if(PositionBackup::isBackupFile(bname))
+            {
+             // resume behind the last frame which made it into the backup
+             long last=currMosqPos->loadFromBackup(bname);
+             if(last>=0)
+              fromFrame=last+(FrameStep>0?FrameStep:1);
+            }
+            else
+            {
+             long last=currMosqPos->loadFromFile(bname,false,true);
+             if(last>=0)
+              fromFrame=last;
+            }
             m_player->setHavePositions();
             frameSelect->setFromFrame(fromFrame);
             m_player->setCurrentFrameNo(fromFrame);
@@ -202,7 +212,12 @@ bool MainWindow::loadFile(const QString &fileName)
 
 bool MainWindow::loadPositionsFile(const QString &fileName,bool dynamic /*=false */)
 {
-    currMosqPos->loadFromFile(fileName.toUtf8().constData(),dynamic,true);
+    if(currMosqPos->loadFromFile(fileName.toUtf8().constData(),dynamic,true)<0)
+    {
+     QMessageBox msgBox;
+     msgBox.setText(QString("Error: not all positions could be loaded, the page file could not be read!"));
+     msgBox.exec();
+    }
     currSeq->setPosfilename(fileName.toUtf8().constData());
     m_player->setHavePositions();
     if(dynamic)
@@ -214,7 +229,12 @@ bool MainWindow::loadPositionsFile(const QString &fileName,bool dynamic /*=false
 
 bool MainWindow::loadPositionsFileRange(const QString &fileName,bool dynamic /*=false */)
 {
-    currMosqPos->loadFromFile(fileName.toUtf8().constData(),fromFrame,toFrame,dynamic,true);
+    if(currMosqPos->loadFromFile(fileName.toUtf8().constData(),fromFrame,toFrame,dynamic,true)<0)
+    {
+     QMessageBox msgBox;
+     msgBox.setText(QString("Error: not all positions could be loaded, the page file could not be read!"));
+     msgBox.exec();
+    }
     currSeq->setPosfilename(fileName.toUtf8().constData());
     m_player->setHavePositions();
     if(dynamic)
@@ -243,7 +263,14 @@ bool MainWindow::savePositionsFile(const QString &fileName, bool selection /*=fa
         }
         else
         {
-         currMosqPos->saveToFile(fileName.toUtf8().constData());
+         if(currMosqPos->saveToFile(fileName.toUtf8().constData())!=0)
+         {
+          // the segmentation backup is the only complete copy left
+          QMessageBox msgBox;
+          msgBox.setText(QString("Error: The positions could not be saved completely, the backup is kept.\n"));
+          msgBox.exec();
+          return false;
+         }
          currSeq->closeBackupFile();
          remove(currSeq->backupName().c_str());
          string nsN=fileName.toUtf8().constData();
@@ -492,6 +519,11 @@ void MainWindow::saveSettingsToFile(string outputFileName)
     fs << "dilute" << dilute;
     fs << "cleanCluster" << cleanCluster;
     fs << "blackOnWhite" << blackOnWhite;
+    fs << "positionMemoryMB" << (int)currMosqPos->getMemoryBudget();
+    fs << "videoDecodeThreads" << currSeq->getVideoThreads();
+    fs << "videoDecodeThreadType" << currSeq->getVideoThreadType();
+    fs << "videoDecodeAhead" << currSeq->getVideoDecodeAhead();
+    fs << "videoFrameCacheMB" << (int)currSeq->getVideoCache();
 }
 
 void MainWindow::loadSettingsFromFile(string inputFileName)
@@ -513,6 +545,29 @@ void MainWindow::loadSettingsFromFile(string inputFileName)
     fs["dilute"] >> dilute;
     fs["cleanCluster"] >> cleanCluster;
     fs["blackOnWhite"] >> blackOnWhite;
+    if(!fs["positionMemoryMB"].empty())
+    {
+        int memMB=0;
+        fs["positionMemoryMB"] >> memMB;
+        if(memMB>=0)
+         currMosqPos->setMemoryBudget(memMB, currSeq->pageName());
+    }
+    if(!fs["videoDecodeThreads"].empty() && !fs["videoDecodeThreadType"].empty() && !fs["videoDecodeAhead"].empty())
+    {
+        int threads=0, type=0, ahead=0;
+        fs["videoDecodeThreads"] >> threads;
+        fs["videoDecodeThreadType"] >> type;
+        fs["videoDecodeAhead"] >> ahead;
+        if(threads!=currSeq->getVideoThreads() || type!=currSeq->getVideoThreadType() || ahead!=currSeq->getVideoDecodeAhead())
+         currSeq->setVideoDecoding(threads, type, ahead);
+    }
+    if(!fs["videoFrameCacheMB"].empty())
+    {
+        int cacheMB=0;
+        fs["videoFrameCacheMB"] >> cacheMB;
+        if(cacheMB>=0)
+         currSeq->setVideoCache(cacheMB);
+    }
     segParam->setMinA(minA);
     segParam->setMaxA(maxA);
     segParam->setFracN(fracN);
@@ -1061,6 +1116,7 @@ bool MainWindow::save_animation(const QString &fileName)
     vset.timebaseden=codecParam->getFrameDen();
     vset.useCrf=codecParam->getUseCrf();
     vset.crf=codecParam->getCrf();
+    vset.preset=codecParam->getPresetName().toUtf8().constData();
     int codecID=codecParam->getCodec();
     int hardwareCodec=codecParam->getHardware();
     vset.by_name=0;
@@ -130,10 +130,14 @@ void MainWindow::createMenus()
     editMenu-> addAction("Show Histogram of Img.", this, SLOT( on_actionShowHistOfImage_triggered() ) );
     editMenu-> addAction("Show Segmentation", this, SLOT( on_actionShowDiffImage_triggered() ) );
     editMenu-> addAction("Show All Points", this, SLOT( on_actionShowPoints_triggered() ) );
+    editMenu-> addAction("Show Activity Timeline", this, SLOT( on_actionShowTimeline_triggered() ) );
     editMenu-> addAction("Clean Cluster (current frame)", this, SLOT( on_actionCleanCluster_triggered() ) );
     editMenu-> addAction("Clean Cluster (all frames)", this, SLOT( on_actionCleanAllCluster_triggered() ) );
     editMenu-> addAction("Reset Positions", this, SLOT( on_actionResetPositions_triggered() ) );
     editMenu-> addAction("Reset Tracks", this, SLOT( on_actionResetTracks_triggered() ) );
+    editMenu-> addAction("Position Memory Budget", this, SLOT( on_actionMemoryBudget_triggered() ) );
+    editMenu-> addAction("Video Decoding", this, SLOT( on_actionVideoDecoding_triggered() ) );
+    editMenu-> addAction("Ingest Video (this)", this, SLOT( on_actionIngestVideo_triggered() ) );
     editMenu-> addAction("Show Table of Points", this, SLOT( on_actionShowTable_triggered() ) );
     editMenu-> addAction("Show Table of all P.", this, SLOT( on_actionShowTableOfAll_triggered() ) );
     editMenu-> addAction("Show Table of Tracks", this, SLOT( on_actionShowTableOfTracks_triggered() ) );
@@ -396,13 +400,14 @@ void MainWindow::fillTableOfTracks()
  
  m_tTableWidget->setSortingEnabled(false);
  int ii=0;
- vector<vector<TrackPoint> >  tmpReg= currReg->getRegistry();
- for(unsigned long n=0; n<tmpReg.size(); n++)
+ vector<int> ids=currReg->trackIDs();
+ for(unsigned long n=0; n<ids.size(); n++)
  {
-     int nPoints=tmpReg[n].size();
-     int id=n;
-     int frameStart=tmpReg[n][0].frame;
-     int frameStop=tmpReg[n][nPoints-1].frame;
+     int id=ids[n];
+     trackSummary s=currReg->getTrackSummary(id);
+     int nPoints=currReg->TrackLength(id);
+     int frameStart=s.firstFrame;
+     int frameStop=s.lastFrame;
      int durration=frameStop-frameStart;
      QTableWidgetItem *item = new QTableWidgetItem;
      item->setData(Qt::EditRole, id);
@@ -494,15 +499,19 @@ void MainWindow::timerEvent(QTimerEvent *event)
             timerID2=-1;
             DisplayProgress->setValue(toFrame-fromFrame+1);
             delete DisplayProgress;
+            currSeq->syncBackupFile();
+            currMosqPos->setJournaling(true);
         }
         workFrame+=FrameStep;
     }
     else
     {
         killTimer(event->timerId());
+        currSeq->syncBackupFile();
         DisplayProgress->setValue(toFrame-fromFrame+1);
         timerID2=-1;
         delete DisplayProgress;
+        currMosqPos->setJournaling(true);
         emit readyToRunNext();
     }
     }
@@ -905,7 +914,7 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
         {
          TrackPoint NewTrackPoint(cM->getX(),cM->getY(),tmp[0],cF->getTsSec(),cF->getTsMSec(),cF->getTsUSec(),
                           cM->getI(),cM->getA(),cF->getMaxDiff(),cF->getMinArea(),cF->getMaxArea(),
-                          cF->getThreshold(),cF->getMinThreshold(),cF->getIth());
+                          cF->getThreshold(),cF->getMinThreshold(),cF->getIth(),cM->getSlot());
          m_player->getTrackPointer(c,r)->addPointToTrack(currT[0], NewTrackPoint);
          m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
          updatePointerOfTracks(c,r);
@@ -1012,7 +1021,7 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
         {
          TrackPoint NewTrackPoint(cM->getX(),cM->getY(),tmp[0],cF->getTsSec(),cF->getTsMSec(),cF->getTsUSec(),
                           cM->getI(),cM->getA(),cF->getMaxDiff(),cF->getMinArea(),cF->getMaxArea(),
-                          cF->getThreshold(),cF->getMinThreshold(),cF->getIth());
+                          cF->getThreshold(),cF->getMinThreshold(),cF->getIth(),cM->getSlot());
          m_player->getTrackPointer(c,r)->addPointToTrack(currT[0], NewTrackPoint);
          m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
          updatePointerOfTracks(c,r);
@@ -1129,7 +1138,7 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
           {
            TrackPoint NewTrackPoint(cM->getX(),cM->getY(),tmp[0],cF->getTsSec(),cF->getTsMSec(),cF->getTsUSec(),
                             cM->getI(),cM->getA(),cF->getMaxDiff(),cF->getMinArea(),cF->getMaxArea(),
-                            cF->getThreshold(),cF->getMinThreshold(),cF->getIth());
+                            cF->getThreshold(),cF->getMinThreshold(),cF->getIth(),cM->getSlot());
            m_player->getTrackPointer(c,r)->addPointToTrack(currT[0], NewTrackPoint);
            m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
            updatePointerOfTracks(c,r);
@@ -1223,6 +1232,12 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
      MosquitoesInSeq* pin=m_player->getMosqPointer(c,r);
      backupPos(seqPointerToSeqNum(m_player->getSeqPointer(c,r)));
      int rem=pin->removePointsInsideOfPolygon(polygon,frameSelect->getFrom(),frameSelect->getTo(),false,m_player->useMetaMode());
+     if(rem<0)
+     {
+      QMessageBox msgBox;
+      msgBox.setText(QString("Error: not all positions could be read back from the page file, the removal stopped!"));
+      msgBox.exec();
+     }
      polygon.clear();
      m_player->clearPolygon(c,r);
      m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
@@ -1251,6 +1266,12 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
      MosquitoesInSeq* pin=m_player->getMosqPointer(c,r);
      backupPos(seqPointerToSeqNum(m_player->getSeqPointer(c,r)));
      int rem=pin->removePointsInsideOfPolygon(polygon,frameSelect->getFrom(),frameSelect->getTo(),true,m_player->useMetaMode());
+     if(rem<0)
+     {
+      QMessageBox msgBox;
+      msgBox.setText(QString("Error: not all positions could be read back from the page file, the removal stopped!"));
+      msgBox.exec();
+     }
      polygon.clear();
      m_player->clearPolygon(c,r);
      m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
@@ -1387,7 +1408,7 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
          MosquitoPosition* cM=cF->mosqi(tmp[1]);
          TrackPoint NewTrackPoint(cM->getX(),cM->getY(),tmp[0],cF->getTsSec(),cF->getTsMSec(),cF->getTsUSec(),
                           cM->getI(),cM->getA(),cF->getMaxDiff(),cF->getMinArea(),cF->getMaxArea(),
-                          cF->getThreshold(),cF->getMinThreshold(),cF->getIth());
+                          cF->getThreshold(),cF->getMinThreshold(),cF->getIth(),cM->getSlot());
          m_player->getTrackPointer(c,r)->addPointToTrack(selectedTrack, NewTrackPoint);
          m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
          m_player->setTrackToHighlight(m_player->getTrackPointer(c,r)->getSingleTrack(selectedTrack),c,r);
@@ -1419,9 +1440,7 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
          if(currT[0]!=selectedTrack)
          {
       backupTracks(seqPointerToSeqNum(m_player->getSeqPointer(c,r)));
-             bool ret=m_player->getTrackPointer(c,r)->joinTracks(selectedTrack, currT[0]);
-             if(currT[0]<selectedTrack && ret)
-               selectedTrack--;
+             m_player->getTrackPointer(c,r)->joinTracks(selectedTrack, currT[0]);
              m_player->drawAllPoints(c, r, frameSelect->getFrom(),frameSelect->getTo());
              m_player->setTrackToHighlight(m_player->getTrackPointer(c,r)->getSingleTrack(selectedTrack),c,r);
          }
@@ -1517,9 +1536,17 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
      if(m_player->getMosqPointer(c,r) && m_player->getTrackPointer(c,r))
      {
        vector<vector<double> > a=m_player->getMosqPointer(c,r)->pointsInsideOfPolygonAsVector(polygon,frameSelect->getFrom(),frameSelect->getTo(),m_player->useMetaMode());
+       int currID=-1;
        if(a.size()>0)
+        currID=m_player->getTrackPointer(c,r)->registerNewMosquito();
+       if(a.size()>0 && currID==-1)
+       {
+         QMessageBox msgBox;
+         msgBox.setText(QString("Error: the registry is full, no track added!"));
+         msgBox.exec();
+       }
+       else if(a.size()>0)
        {
-         int currID=m_player->getTrackPointer(c,r)->registerNewMosquito();
          vector<int> tracksToJoin;
          for(int ii=0; ii<a.size(); ii++)
          {
@@ -1536,7 +1563,7 @@ void MainWindow::on_mouseClicked(QPoint m, int c, int r)
               }
               else
               {
-               TrackPoint NewTrackPoint(a[ii][0],a[ii][1],a[ii][2],a[ii][3],a[ii][4],a[ii][5],a[ii][6],a[ii][7],a[ii][8],a[ii][9],a[ii][10],a[ii][11],a[ii][12],a[ii][13]);
+               TrackPoint NewTrackPoint(a[ii][0],a[ii][1],a[ii][2],a[ii][3],a[ii][4],a[ii][5],a[ii][6],a[ii][7],a[ii][8],a[ii][9],a[ii][10],a[ii][11],a[ii][12],a[ii][13],mp->getSlot());
                m_player->getTrackPointer(c,r)->updateTrack(currID,NewTrackPoint);
               }
             }
@@ -1698,6 +1725,19 @@ void MainWindow::createToolBar()
          }
       }
   });
+  pointsToolBar-> addAction(tr("Redo"), this,[this](){
+      if(seq.size()>0)
+      {
+         int sqn=seqPointerToSeqNum(currSeq);
+         if(sqn!=-1)
+         {
+          redoPos(sqn);
+          m_player->showImageWithPoints(m_player->getCurrentFrameNo());
+          if(showAllPoints)
+           m_player->drawAllPoints(-1, -1, frameSelect->getFrom(),frameSelect->getTo());
+         }
+      }
+  });
 
  QToolBar *tracksToolBar = addToolBar(tr("Tracks"));
  tracksToolBar->setObjectName("TracksToolBar");
@@ -17,6 +17,7 @@
  * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "MosquitoPosition.hpp"
+#include "BinaryIO.hpp"
 #include <string>
 #include <iostream>
 //opencv
@@ -42,6 +43,7 @@ using namespace std;
 MosquitoPosition::MosquitoPosition(double ix, double iy, double iarea, double imaxInt,double icircularity, double iinertia, double iconvexity, double iradius, vector<cv::Point> ic/* = vector<cv::Point>() */)
 {
     flag=1;
+    slot=0;
     x=ix;
     y=iy;
     area=iarea;
@@ -66,6 +68,7 @@ MosquitoPosition::MosquitoPosition(double ix, double iy, double iarea, double im
 MosquitoPosition::MosquitoPosition(const MosquitoPosition& a)
 {
     flag=a.flag;
+    slot=a.slot;
     x=a.x;
     y=a.y;
     area=a.area;
@@ -272,4 +275,62 @@ bool MosquitoPosition::calculateContourStatistics()
  }
  else
   return false;
-}
\ No newline at end of file
+}
+
+void MosquitoPosition::toBinary(vector<char>& b)
+{
+    putBinary<double>(b, x);
+    putBinary<double>(b, y);
+    putBinary<double>(b, area);
+    putBinary<double>(b, maxInt);
+    putBinary<int32_t>(b, flag);
+    putBinary<double>(b, circularity);
+    putBinary<double>(b, inertia);
+    putBinary<double>(b, convexity);
+    putBinary<double>(b, radius);
+    putBinary<uint32_t>(b, slot);
+    putBinary<uint32_t>(b, ID.size());
+    b.insert(b.end(), ID.begin(), ID.end());
+    putBinary<uint32_t>(b, hasContour?c.size():0);
+    if(hasContour)
+     for(unsigned long k=0; k<c.size(); k++)
+     {
+      putBinary<int32_t>(b, c[k].x);
+      putBinary<int32_t>(b, c[k].y);
+     }
+}
+
+bool MosquitoPosition::fromBinary(const char*& p, const char* end, vector<MosquitoPosition>& out)
+{
+    double ix,iy,ia,ii,ic,iin,ico,ir;
+    int32_t iflag;
+    uint32_t islot,nID,nc;
+    if(!(getBinary(p,end,ix) && getBinary(p,end,iy) && getBinary(p,end,ia) && getBinary(p,end,ii) &&
+         getBinary(p,end,iflag) && getBinary(p,end,ic) && getBinary(p,end,iin) && getBinary(p,end,ico) &&
+         getBinary(p,end,ir) && getBinary(p,end,islot) && getBinary(p,end,nID)))
+     return false;
+    if((unsigned long)(end-p)<nID)
+     return false;
+    string iID(p,nID);
+    p+=nID;
+    if(!getBinary(p,end,nc) || (unsigned long)(end-p)<(unsigned long)nc*2*sizeof(int32_t))
+     return false;
+    vector<cv::Point> icont(nc);
+    for(uint32_t k=0; k<nc; k++)
+    {
+     int32_t cx,cy;
+     getBinary(p,end,cx);
+     getBinary(p,end,cy);
+     icont[k]=cv::Point(cx,cy);
+    }
+    out.push_back(MosquitoPosition(ix,iy,ia,ii,ic,iin,ico,ir,icont));
+    out.back().flag=iflag;
+    out.back().slot=islot;
+    out.back().ID=iID;
+    return true;
+}
+
+unsigned long MosquitoPosition::memoryUsage()
+{
+    return sizeof(MosquitoPosition)+c.capacity()*sizeof(cv::Point)+ID.capacity();
+}
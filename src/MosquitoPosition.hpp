@@ -69,6 +69,11 @@ public:
     bool MosquitoHasContour();
     bool setContour(vector<cv::Point> ic, bool ignoreError = false);
     bool calculateContourStatistics();
+    unsigned int getSlot() const {return slot;};
+    void setSlot(unsigned int s){slot=s;};
+    void toBinary(vector<char>& b);
+    static bool fromBinary(const char*& p, const char* end, vector<MosquitoPosition>& out);
+    unsigned long memoryUsage();
 
 private:
     double x;
@@ -83,6 +88,8 @@ private:
     double radius;
     vector<cv::Point> c;
     bool hasContour;
+    // per frame handle, assigned by MosquitoesInFrame and never reused
+    unsigned int slot;
 };
 #endif //MOSQUITOPOSITION_hpp
 
@@ -23,6 +23,7 @@
 #include "MosquitoPosition.hpp"
 #include <vector>
 #include <iostream>
+#include <stdint.h>
 //opencv
 #if CV_MAJOR_VERSION < 3
 #include "opencv2/core/core.hpp"
@@ -46,20 +47,69 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
 #define PI 3.14159265
+#define FRAMEINDEXBLOCK 256
+#define PICKCELLSIZE 16
+#define TRACKSLOTBITS 22
+#define TRACKSLOTMASK ((1<<TRACKSLOTBITS)-1)
+#define TRACKGENERATIONMASK 0x1ff
+#define TRACKSNAPSHOTCHUNK 256
 #include <QProgressDialog>
 #include <QMessageBox>
 
 using namespace std;
 
+bool sortTrackConnectionByCost(const trackConnection &a, const trackConnection &b)
+{
+    if(a.cost!=b.cost) return a.cost < b.cost;
+    if(a.source!=b.source) return a.source < b.source;
+    return a.target < b.target;
+}
+
+long long pickCellKey(long long b, long long cx, long long cy)
+{
+    // frame block and grid cell packed into one key of the picking index,
+    // collisions only add candidates that are then rejected by their distance
+    return (b<<40)^((cx&0xfffff)<<20)^(cy&0xfffff);
+}
+
+long long pickCellKey(int frame, double x, double y)
+{
+    return pickCellKey((long long)(max(frame,0)/FRAMEINDEXBLOCK),(long long)floor(x/PICKCELLSIZE),(long long)floor(y/PICKCELLSIZE));
+}
+
+unsigned long long gridKey(long long cx, long long cy)
+{
+    // both cells as unsigned 32 bit halves, shifting a negative cell would be undefined
+    return ((unsigned long long)(uint32_t)cx<<32)|(uint32_t)cy;
+}
+
+unsigned long findTrackRoot(vector<unsigned long> &parent, unsigned long i)
+{
+    while(parent[i]!=i)
+    {
+     parent[i]=parent[parent[i]];
+     i=parent[i];
+    }
+    return i;
+}
+
 MosquitoRegistry::MosquitoRegistry()
 {
-    srand (static_cast <unsigned> (time(0)));
+    frameIndexValid=false;
+    pickIndexValid=false;
+    nextColor=0;
+    FreeHead=0;
+    liveTracks=0;
 }
 
 MosquitoRegistry::MosquitoRegistry(const MosquitoRegistry& a)
 {
-    srand (static_cast <unsigned> (time(0)));
+    frameIndexValid=false;
+    pickIndexValid=false;
     for(unsigned int i=0; i<a.Registry.size(); i++)
     {
      vector<TrackPoint> track;
@@ -69,21 +119,126 @@ MosquitoRegistry::MosquitoRegistry(const MosquitoRegistry& a)
      }
      Registry.push_back(track);
     }
+    Summary=a.Summary;
+    nextColor=a.nextColor;
+    Generation=a.Generation;
+    FreeSlots=a.FreeSlots;
+    FreeHead=a.FreeHead;
+    Order=a.Order;
+    OrderPos=a.OrderPos;
+    liveTracks=a.liveTracks;
+}
+
+long MosquitoRegistry::trackSlot(int ID)
+{
+    // slot of a track ID, -1 if the track was deleted in the meantime
+    if(ID<0)
+     return -1;
+    unsigned long slot=ID & TRACKSLOTMASK;
+    if(slot>=Registry.size() || OrderPos[slot]<0 || (Generation[slot] & TRACKGENERATIONMASK)!=(unsigned int)(ID>>TRACKSLOTBITS))
+     return -1;
+    return slot;
+}
+
+int MosquitoRegistry::trackID(unsigned long slot)
+{
+    return (int)(((Generation[slot] & TRACKGENERATIONMASK)<<TRACKSLOTBITS) | slot);
+}
+
+bool MosquitoRegistry::trackSlotAvailable()
+{
+    return FreeHead<FreeSlots.size() || Registry.size()<=TRACKSLOTMASK;
+}
+
+long MosquitoRegistry::newTrackSlot()
+{
+    // freed slots are reused first in first out, so the generation of a slot
+    // only advances once all other free slots were used; new tracks are
+    // always added at the end of the order
+    unsigned long slot;
+    if(FreeHead<FreeSlots.size())
+    {
+     slot=FreeSlots[FreeHead++];
+     if(FreeHead==FreeSlots.size())
+     {
+      FreeSlots.clear();
+      FreeHead=0;
+      sharedFree.clear();
+     }
+     else if(FreeHead>=TRACKSNAPSHOTCHUNK && 2*FreeHead>=FreeSlots.size())
+     {
+      FreeSlots.erase(FreeSlots.begin(), FreeSlots.begin()+FreeHead);
+      FreeHead=0;
+      sharedFree.clear();
+     }
+     Summary[slot]=newTrackSummary();
+    }
+    else if(Registry.size()<=TRACKSLOTMASK)
+    {
+     slot=Registry.size();
+     Registry.push_back(vector<TrackPoint>());
+     Summary.push_back(newTrackSummary());
+     Generation.push_back(0);
+     OrderPos.push_back(-1);
+    }
+    else
+    {
+     // a further slot would alias the IDs of existing tracks
+     cerr<<"Error: the registry is full with "<<Registry.size()<<" tracks, no new track added!\n";
+     return -1;
+    }
+    OrderPos[slot]=Order.size();
+    markOrderChanged(sharedOrder, Order.size());
+    Order.push_back(slot);
+    liveTracks++;
+    markTrackChanged(slot);
+    return slot;
+}
+
+void MosquitoRegistry::compactTrackOrder()
+{
+    unsigned long k=0;
+    for(unsigned long i=0; i<Order.size(); i++)
+     if(OrderPos[Order[i]]==(long)i)
+     {
+      Order[k]=Order[i];
+      OrderPos[Order[k]]=k;
+      k++;
+     }
+    Order.resize(k);
+    // all positions moved
+    sharedOrder.clear();
+    sharedChunks.clear();
+}
+
+vector<int> MosquitoRegistry::trackIDs()
+{
+    vector<int> ids;
+    ids.reserve(liveTracks);
+    for(unsigned long i=0; i<Order.size(); i++)
+     if(OrderPos[Order[i]]==(long)i)
+      ids.push_back(trackID(Order[i]));
+    return ids;
 }
 
 int MosquitoRegistry::registerNewMosquito()
 {
-    vector<TrackPoint> tmp;
-    int ID=Registry.size();
-    Registry.push_back(tmp);
-    return ID;
+    long slot=newTrackSlot();
+    if(slot<0)
+     return -1;
+    addToFrameIndex(slot);
+    return trackID(slot);
 }
 
 int MosquitoRegistry::updateTrack(unsigned long ID, TrackPoint tmp)
 {
-    if(ID<Registry.size())
+    long slot=trackSlot(ID);
+    if(slot>=0)
     {
-     Registry[ID].push_back(tmp);
+     Registry[slot].push_back(tmp);
+     Summary[slot].valid=false;
+     addToFrameIndex(slot);
+     markTrackChanged(slot);
      return 0;
     }
     else
@@ -93,16 +248,18 @@ int MosquitoRegistry::updateTrack(unsigned long ID, TrackPoint tmp)
 int MosquitoRegistry::TrackLength(int ID)
 {
      int length=0;
-     if(ID>=0 && ID<Registry.size())
-      length=Registry[ID].size();
+     long slot=trackSlot(ID);
+     if(slot>=0)
+      length=Registry[slot].size();
      return length;
 }
 
 
-vector<vector<double> >  MosquitoRegistry::TrackMotionVector(int ID, int m)
+vector<vector<double> >  MosquitoRegistry::TrackMotionVector(int trackId, int m)
 {
      vector<vector<double> > temp;
-     if(ID<Registry.size() && ID>=0)
+     long ID=trackSlot(trackId);
+     if(ID>=0)
      {
       if(Registry[ID].size()>1)
       for(int j=Registry[ID].size()-1;j>=max(1,((int)Registry[ID].size()-1-m));j--)
@@ -118,13 +275,360 @@ vector<vector<double> >  MosquitoRegistry::TrackMotionVector(int ID, int m)
      return temp;
 }
 
+trackSummary MosquitoRegistry::newTrackSummary()
+{
+    // the golden ratio spreads consecutive tracks evenly over the colour scale
+    trackSummary tmp;
+    tmp.valid=false;
+    tmp.color=fmod(double(nextColor)*0.6180339887498949,1.0);
+    nextColor++;
+    return tmp;
+}
+
+void MosquitoRegistry::invalidateTrack(unsigned long ID)
+{
+    if(ID<Summary.size())
+     Summary[ID].valid=false;
+    invalidateFrameIndex();
+    markTrackChanged(ID);
+}
+
+void MosquitoRegistry::eraseTrack(unsigned long ID)
+{
+    // the slot is freed in O(1), its generation is increased so that the
+    // old track ID does not refer to the next track stored in it; a slot whose
+    // generation wraps around is retired, as its next ID would be an old one
+    if(OrderPos[ID]<0)
+     return;
+    vector<TrackPoint>().swap(Registry[ID]);
+    Summary[ID].valid=false;
+    vector<vector<double> >().swap(Summary[ID].statistics);
+    Generation[ID]++;
+    OrderPos[ID]=-1;
+    liveTracks--;
+    if((Generation[ID] & TRACKGENERATIONMASK)!=0)
+    {
+     markOrderChanged(sharedFree, FreeSlots.size());
+     FreeSlots.push_back(ID);
+    }
+    markTrackChanged(ID);
+    if(frameIndexValid && ID<trackFirstFrame.size())
+    {
+     trackFirstFrame[ID]=0;
+     trackLastFrame[ID]=-1;
+     trackIsSorted[ID]=true;
+    }
+    if(Order.size()>2*liveTracks+64)
+     compactTrackOrder();
+}
+
+void MosquitoRegistry::updateTrackSummary(unsigned long ID)
+{
+    trackSummary &s=Summary[ID];
+    if(s.valid)
+     return;
+    s.firstFrame=0;
+    s.lastFrame=-1;
+    s.length=0;
+    s.duration=0;
+    s.meanSpeed=0;
+    s.maxSpeed=0;
+    s.minX=0;
+    s.maxX=0;
+    s.minY=0;
+    s.maxY=0;
+    vector<TrackPoint> &t=Registry[ID];
+    if(t.size()>0)
+    {
+     s.firstFrame=t[0].frame;
+     s.lastFrame=t[t.size()-1].frame;
+     s.minX=t[0].x;
+     s.maxX=t[0].x;
+     s.minY=t[0].y;
+     s.maxY=t[0].y;
+     for(unsigned long j=1; j<t.size(); j++)
+     {
+      double d=sqrt(pow(t[j].x-t[j-1].x,2)+pow(t[j].y-t[j-1].y,2));
+      double dt=t[j].time()-t[j-1].time();
+      s.length+=d;
+      if(dt>0 && d/dt>s.maxSpeed) s.maxSpeed=d/dt;
+      if(t[j].x<s.minX) s.minX=t[j].x;
+      if(t[j].x>s.maxX) s.maxX=t[j].x;
+      if(t[j].y<s.minY) s.minY=t[j].y;
+      if(t[j].y>s.maxY) s.maxY=t[j].y;
+     }
+     s.duration=t[t.size()-1].time()-t[0].time();
+     if(s.duration>0)
+      s.meanSpeed=s.length/s.duration;
+    }
+    s.statistics=trackStatistics(t);
+    s.valid=true;
+}
+
+trackSummary MosquitoRegistry::getTrackSummary(int ID)
+{
+    long slot=trackSlot(ID);
+    if(slot>=0)
+    {
+     updateTrackSummary(slot);
+     return Summary[slot];
+    }
+    trackSummary tmp;
+    tmp.valid=false;
+    tmp.firstFrame=0;
+    tmp.lastFrame=-1;
+    tmp.length=0;
+    tmp.duration=0;
+    tmp.meanSpeed=0;
+    tmp.maxSpeed=0;
+    tmp.minX=0;
+    tmp.maxX=0;
+    tmp.minY=0;
+    tmp.maxY=0;
+    tmp.color=0;
+    return tmp;
+}
+
+vector<vector<double> > MosquitoRegistry::trackStatistics(int ID)
+{
+    long slot=trackSlot(ID);
+    if(slot>=0)
+    {
+     updateTrackSummary(slot);
+     return Summary[slot].statistics;
+    }
+    vector<vector<double> > a;
+    return a;
+}
+
+void MosquitoRegistry::invalidateFrameIndex()
+{
+    frameIndexValid=false;
+}
+
+void MosquitoRegistry::addToFrameIndex(unsigned long ID)
+{
+    // points are appended in time order while tracking, so the index
+    // can be extended instead of rebuilding it for every new point
+    if(!frameIndexValid)
+     return;
+    if(trackFirstFrame.size()<Registry.size())
+    {
+     trackFirstFrame.resize(Registry.size(),0);
+     trackLastFrame.resize(Registry.size(),-1);
+     trackIsSorted.resize(Registry.size(),true);
+    }
+    if(Registry[ID].size()==0)
+     return;
+    int f=Registry[ID][Registry[ID].size()-1].frame;
+    if(Registry[ID].size()==1)
+    {
+     trackFirstFrame[ID]=f;
+     trackLastFrame[ID]=f;
+     unsigned long b=max(f,0)/FRAMEINDEXBLOCK;
+     if(frameBlocks.size()<=b) frameBlocks.resize(b+1);
+     frameBlocks[b].push_back(ID);
+    }
+    else if(f>=trackLastFrame[ID])
+    {
+     unsigned long bOld=max(trackLastFrame[ID],0)/FRAMEINDEXBLOCK;
+     unsigned long bNew=max(f,0)/FRAMEINDEXBLOCK;
+     if(frameBlocks.size()<=bNew) frameBlocks.resize(bNew+1);
+     for(unsigned long b=bOld+1; b<=bNew; b++)
+      frameBlocks[b].push_back(ID);
+     trackLastFrame[ID]=f;
+    }
+    else
+     invalidateFrameIndex();
+}
+
+void MosquitoRegistry::updateFrameIndex()
+{
+    if(frameIndexValid)
+     return;
+    unsigned long nT=Registry.size();
+    trackFirstFrame.assign(nT,0);
+    trackLastFrame.assign(nT,-1);
+    trackIsSorted.assign(nT,true);
+    frameBlocks.clear();
+    for(unsigned long i=0; i<nT; i++)
+    {
+     if(Registry[i].size()==0)
+      continue;
+     int f0=Registry[i][0].frame;
+     int f1=f0;
+     for(unsigned long j=1; j<Registry[i].size(); j++)
+     {
+      int f=Registry[i][j].frame;
+      if(f<Registry[i][j-1].frame) trackIsSorted[i]=false;
+      if(f<f0) f0=f;
+      if(f>f1) f1=f;
+     }
+     trackFirstFrame[i]=f0;
+     trackLastFrame[i]=f1;
+     unsigned long b0=max(f0,0)/FRAMEINDEXBLOCK;
+     unsigned long b1=max(f1,0)/FRAMEINDEXBLOCK;
+     if(frameBlocks.size()<=b1) frameBlocks.resize(b1+1);
+     for(unsigned long b=b0; b<=b1; b++)
+      frameBlocks[b].push_back(i);
+    }
+    frameIndexValid=true;
+}
+
+vector<unsigned long> MosquitoRegistry::tracksInFrameRange(int fromFrame, int toFrame, int mint)
+{
+    // returns the tracks with points in [fromFrame,toFrame] in ascending order,
+    // for mint==0 all tracks are returned as the callers expect one entry per track
+    vector<unsigned long> ids;
+    updateFrameIndex();
+    if(mint==0)
+    {
+     ids.reserve(liveTracks);
+     for(unsigned long i=0; i<Registry.size(); i++)
+      if(OrderPos[i]>=0)
+       ids.push_back(i);
+     return ids;
+    }
+    if(toFrame<fromFrame || toFrame<0 || frameBlocks.size()==0)
+     return ids;
+    unsigned long b0=max(fromFrame,0)/FRAMEINDEXBLOCK;
+    unsigned long b1=min((unsigned long)(toFrame/FRAMEINDEXBLOCK),(unsigned long)frameBlocks.size()-1);
+    for(unsigned long b=b0; b<=b1; b++)
+     for(unsigned long k=0; k<frameBlocks[b].size(); k++)
+     {
+      unsigned long i=frameBlocks[b][k];
+      if(trackFirstFrame[i]<=toFrame && trackLastFrame[i]>=fromFrame)
+       ids.push_back(i);
+     }
+    sort(ids.begin(),ids.end());
+    ids.erase(unique(ids.begin(),ids.end()),ids.end());
+    return ids;
+}
+
+void MosquitoRegistry::pointsInFrameRange(unsigned long ID, int fromFrame, int toFrame, unsigned long &jb, unsigned long &je)
+{
+    // range of points of track ID that can lie in [fromFrame,toFrame],
+    // unsorted tracks return the whole track and have to be filtered by the caller
+    jb=0;
+    je=0;
+    if(ID>=Registry.size() || Registry[ID].size()==0)
+     return;
+    updateFrameIndex();
+    if(trackFirstFrame[ID]>toFrame || trackLastFrame[ID]<fromFrame)
+     return;
+    if(!trackIsSorted[ID])
+    {
+     je=Registry[ID].size();
+     return;
+    }
+    vector<TrackPoint>::iterator b=lower_bound(Registry[ID].begin(),Registry[ID].end(),fromFrame,
+                                   [](const TrackPoint &a, int f) { return a.frame < f; });
+    vector<TrackPoint>::iterator e=upper_bound(b,Registry[ID].end(),toFrame,
+                                   [](int f, const TrackPoint &a) { return f < a.frame; });
+    jb=b-Registry[ID].begin();
+    je=e-Registry[ID].begin();
+}
+
+void MosquitoRegistry::invalidatePickIndex()
+{
+    pickIndexValid=false;
+}
+
+void MosquitoRegistry::markTrackChanged(unsigned long ID)
+{
+    // called whenever the points of a track change: the track is re-indexed
+    // for picking and its copy shared with the snapshots is dropped
+    if(pickIndexValid)
+     pickDirty.push_back(ID);
+    if(ID<sharedTracks.size())
+     sharedTracks[ID].reset();
+    if(ID/TRACKSNAPSHOTCHUNK<sharedChunks.size())
+     sharedChunks[ID/TRACKSNAPSHOTCHUNK].reset();
+}
+
+void MosquitoRegistry::markOrderChanged(vector<shared_ptr<const vector<unsigned long> > > &shared, unsigned long i)
+{
+    if(i/TRACKSNAPSHOTCHUNK<shared.size())
+     shared.resize(i/TRACKSNAPSHOTCHUNK);
+}
+
+void MosquitoRegistry::clearShared()
+{
+    sharedTracks.clear();
+    sharedChunks.clear();
+    sharedOrder.clear();
+    sharedFree.clear();
+}
+
+void MosquitoRegistry::removeFromPickIndex(unsigned long ID)
+{
+    if(ID>=pickCellsOfTrack.size())
+     return;
+    for(unsigned long c=0; c<pickCellsOfTrack[ID].size(); c++)
+    {
+     unordered_map<long long, vector<pair<unsigned long,unsigned long> > >::iterator it=pickCells.find(pickCellsOfTrack[ID][c]);
+     if(it==pickCells.end())
+      continue;
+     vector<pair<unsigned long,unsigned long> > &e=it->second;
+     e.erase(remove_if(e.begin(), e.end(),
+             [ID](const pair<unsigned long,unsigned long> &a) { return a.first==ID; }), e.end());
+     if(e.size()==0)
+      pickCells.erase(it);
+    }
+    vector<long long>().swap(pickCellsOfTrack[ID]);
+}
+
+void MosquitoRegistry::addToPickIndex(unsigned long ID)
+{
+    if(pickCellsOfTrack.size()<=ID)
+     pickCellsOfTrack.resize(ID+1);
+    vector<long long> &cells=pickCellsOfTrack[ID];
+    for(unsigned long j=0; j<Registry[ID].size(); j++)
+    {
+     long long c=pickCellKey(Registry[ID][j].frame,Registry[ID][j].x,Registry[ID][j].y);
+     pickCells[c].push_back(make_pair(ID,j));
+     if(cells.size()==0 || cells[cells.size()-1]!=c)
+      cells.push_back(c);
+    }
+    sort(cells.begin(),cells.end());
+    cells.erase(unique(cells.begin(),cells.end()),cells.end());
+}
+
+void MosquitoRegistry::updatePickIndex()
+{
+    if(!pickIndexValid)
+    {
+     unsigned long nT=Registry.size();
+     pickCells.clear();
+     pickCellsOfTrack.assign(nT,vector<long long>());
+     pickDirty.clear();
+     for(unsigned long i=0; i<nT; i++)
+      addToPickIndex(i);
+     pickIndexValid=true;
+     return;
+    }
+    sort(pickDirty.begin(),pickDirty.end());
+    pickDirty.erase(unique(pickDirty.begin(),pickDirty.end()),pickDirty.end());
+    for(unsigned long k=0; k<pickDirty.size(); k++)
+    {
+     removeFromPickIndex(pickDirty[k]);
+     addToPickIndex(pickDirty[k]);
+    }
+    pickDirty.clear();
+}
+
 vector<vector<cv::Point2f> > MosquitoRegistry::getAllTracks(unsigned long frame,int lastn, int mint/*=0*/)
 {
     vector<vector<cv::Point2f> > tmptmp;
-    for(unsigned long i=0; i<Registry.size();i++)
+    int fromFrame=(int)frame-(int)lastn+1;
+    vector<unsigned long> ids=tracksInFrameRange(fromFrame,(int)frame,mint);
+    for(unsigned long k=0; k<ids.size();k++)
     {
+        unsigned long i=ids[k];
+        unsigned long jb,je;
+        pointsInFrameRange(i,fromFrame,(int)frame,jb,je);
         vector<cv::Point2f> tmp;
-        for(unsigned long j=0; j<Registry[i].size(); j++)
+        for(unsigned long j=jb; j<je; j++)
         if(Registry[i][j].frame>(int)frame-(int)lastn && Registry[i][j].frame<=frame)
         {
         cv::Point2f m(Registry[i][j].x,Registry[i][j].y);
@@ -139,10 +643,14 @@ vector<vector<cv::Point2f> > MosquitoRegistry::getAllTracks(unsigned long frame,
 vector<vector<cv::Point2f> > MosquitoRegistry::getAllTracksInInterval(unsigned long fromFrame, unsigned long toFrame, int mint/*=0*/)
 {
     vector<vector<cv::Point2f> > tmptmp;
-    for(unsigned long i=0; i<Registry.size();i++)
+    vector<unsigned long> ids=tracksInFrameRange((int)fromFrame,(int)toFrame-1,mint);
+    for(unsigned long k=0; k<ids.size();k++)
     {
+        unsigned long i=ids[k];
+        unsigned long jb,je;
+        pointsInFrameRange(i,(int)fromFrame,(int)toFrame-1,jb,je);
         vector<cv::Point2f> tmp;
-        for(unsigned long j=0; j<Registry[i].size(); j++)
+        for(unsigned long j=jb; j<je; j++)
         if(Registry[i][j].frame>=(int)fromFrame && Registry[i][j].frame<toFrame)
         {
         cv::Point2f m(Registry[i][j].x,Registry[i][j].y);
@@ -160,11 +668,12 @@ vector<vector<cv::Point2f> > MosquitoRegistry::getSelectedTracks(vector<int> Tra
     for(unsigned long i=0; i<TrackIDs.size();i++)
     {
         vector<cv::Point2f> tmp;
-        if(TrackIDs[i]<Registry.size() && TrackIDs[i]>=0)
+        long slot=trackSlot(TrackIDs[i]);
+        if(slot>=0)
         {
-         for(unsigned long j=0; j<Registry[TrackIDs[i]].size(); j++)
+         for(unsigned long j=0; j<Registry[slot].size(); j++)
          {
-         cv::Point2f m(Registry[TrackIDs[i]][j].x,Registry[TrackIDs[i]][j].y);
+         cv::Point2f m(Registry[slot][j].x,Registry[slot][j].y);
          tmp.push_back(m);
          }
          if(tmp.size()>=mint)
@@ -177,11 +686,15 @@ vector<vector<cv::Point2f> > MosquitoRegistry::getSelectedTracks(vector<int> Tra
 vector<double> MosquitoRegistry::getTrackMeta(unsigned long frame,int lastn, int mint/*=0*/,bool random /*=false*/, bool colorByFlag /*=false*/)
 {
     vector<double> tmp;
-    srand (static_cast <unsigned> (time(0)));
-    for(unsigned long i=0; i<Registry.size();i++)
+    int fromFrame=(int)frame-(int)lastn+1;
+    vector<unsigned long> ids=tracksInFrameRange(fromFrame,(int)frame,mint);
+    for(unsigned long k=0; k<ids.size();k++)
     {
+        unsigned long i=ids[k];
+        unsigned long jb,je;
+        pointsInFrameRange(i,fromFrame,(int)frame,jb,je);
         int displayTrack=0;
-        for(unsigned long j=0; j<Registry[i].size(); j++)
+        for(unsigned long j=jb; j<je; j++)
         if(Registry[i][j].frame>(int)frame-(int)lastn && Registry[i][j].frame<=frame)
         {
            displayTrack++;
@@ -190,10 +703,9 @@ vector<double> MosquitoRegistry::getTrackMeta(unsigned long frame,int lastn, int
         {
          if(random)
          {
-          double r = static_cast <double> (rand()) / static_cast <double> (RAND_MAX);
-          tmp.push_back(r);
+          tmp.push_back(Summary[i].color);
          }
-         else if(colorByFlag)
+         else if(colorByFlag && Registry[i].size()>0)
          {
           int foo=0;
           if(Registry[i][0].flag>0 && Registry[i][Registry[i].size()-1].flag>0) foo=1;
@@ -204,6 +716,10 @@ vector<double> MosquitoRegistry::getTrackMeta(unsigned long frame,int lastn, int
           else if(foo==2) tmp.push_back(5./8.);
           else if(foo==3) tmp.push_back(7./8.);
          }
+         else if(colorByFlag)
+         {
+          tmp.push_back(1./8.);
+         }
          else
          {
           tmp.push_back(i/double(Registry.size()));
@@ -216,10 +732,14 @@ vector<double> MosquitoRegistry::getTrackMeta(unsigned long frame,int lastn, int
 vector<double> MosquitoRegistry::getTrackMetaInInterval(unsigned long fromFrame, unsigned long toFrame, int mint/*=0*/,bool random /*=false*/, bool colorByFlag /*=false*/)
 {
     vector<double> tmp;
-    for(unsigned long i=0; i<Registry.size();i++)
+    vector<unsigned long> ids=tracksInFrameRange((int)fromFrame,(int)toFrame-1,mint);
+    for(unsigned long k=0; k<ids.size();k++)
     {
+        unsigned long i=ids[k];
+        unsigned long jb,je;
+        pointsInFrameRange(i,(int)fromFrame,(int)toFrame-1,jb,je);
         int displayTrack=0;
-        for(unsigned long j=0; j<Registry[i].size(); j++)
+        for(unsigned long j=jb; j<je; j++)
         if(Registry[i][j].frame>=(int)fromFrame && Registry[i][j].frame<toFrame)
         {
            displayTrack++;
@@ -232,8 +752,7 @@ vector<double> MosquitoRegistry::getTrackMetaInInterval(unsigned long fromFrame,
           {
            if(random)
            {
-            double r = static_cast <double> (rand()) / static_cast <double> (RAND_MAX);
-            tmp.push_back(r);
+            tmp.push_back(Summary[i].color);
            }
            else if(colorByFlag)
            {
@@ -267,28 +786,28 @@ vector<double> MosquitoRegistry::getSelectedTracksMeta(vector<int> TrackIDs, int
     for(unsigned long i=0; i<TrackIDs.size();i++)
     {
         int displayTrack=0;
-        if(TrackIDs[i]<Registry.size() && TrackIDs[i]>=0)
+        long slot=trackSlot(TrackIDs[i]);
+        if(slot>=0)
         {
-         for(unsigned long j=0; j<Registry[TrackIDs[i]].size(); j++)
+         for(unsigned long j=0; j<Registry[slot].size(); j++)
          {
            displayTrack++;
          }
          if(displayTrack>=mint)
          {
-          if(Registry[TrackIDs[i]].size()>0)
+          if(Registry[slot].size()>0)
           {
            {
             if(random)
             {
-             double r = static_cast <double> (rand()) / static_cast <double> (RAND_MAX);
-             tmp.push_back(r);
+             tmp.push_back(Summary[slot].color);
             }
             else if(colorByFlag)
             {
              int foo=0;
-             if(Registry[TrackIDs[i]][0].flag>0 && Registry[TrackIDs[i]][Registry[TrackIDs[i]].size()-1].flag>0) foo=1;
-             else if(Registry[TrackIDs[i]][Registry[TrackIDs[i]].size()-1].flag>0) foo=2;
-             else if(Registry[TrackIDs[i]][0].flag>0) foo=3;
+             if(Registry[slot][0].flag>0 && Registry[slot][Registry[slot].size()-1].flag>0) foo=1;
+             else if(Registry[slot][Registry[slot].size()-1].flag>0) foo=2;
+             else if(Registry[slot][0].flag>0) foo=3;
              if(foo==0) tmp.push_back(1./8.);
              else if(foo==1) tmp.push_back(3./8.);
              else if(foo==2) tmp.push_back(5./8.);
@@ -324,8 +843,13 @@ int MosquitoRegistry::saveToFile(string filename)
         }
         else
         {
-            for(unsigned long i=0; i<Registry.size();i++)
+            // tracks are written in their order and numbered consecutively
+            unsigned long nWritten=0;
+            for(unsigned long k=0; k<Order.size();k++)
             {
+                unsigned long i=Order[k];
+                if(OrderPos[i]!=(long)k || Registry[i].size()==0)
+                 continue;
                 double minfr=Registry[i][0].frame;
                 double maxfr=Registry[i][Registry[i].size()-1].frame;
                 for(unsigned long j=0; j<Registry[i].size(); j++)
@@ -339,11 +863,12 @@ int MosquitoRegistry::saveToFile(string filename)
                         static_cast<double>(Registry[i][j].frame),
                         minfr,
                         maxfr,
-                        static_cast<double>(i),
+                        static_cast<double>(nWritten),
                         static_cast<double>(Registry[i][j].tsec),
                         static_cast<double>(Registry[i][j].tmsec),
                         static_cast<double>(Registry[i][j].tusec));
                 }
+                nWritten++;
             }
         }
         fclose(pFile);        
@@ -354,6 +879,7 @@ int MosquitoRegistry::saveToFile(string filename)
 int MosquitoRegistry::loadFromFile(string filename, bool showProgress /*=false*/)
 {
     vector<vector<int> > idMap;
+    invalidatePickIndex();
     FILE * pFile;
     pFile = fopen (filename.c_str(),"r");
     fseek( pFile, 0, SEEK_END );
@@ -429,20 +955,34 @@ int MosquitoRegistry::loadFromFile(string filename, bool showProgress /*=false*/
     }
 
     fclose(pFile);
+    // tracks were grown point by point, drop the spare capacity
+    for(unsigned long i=0; i<Registry.size(); i++)
+     Registry[i].shrink_to_fit();
     return 0;
 }
 
 int MosquitoRegistry::reset()
 {
     Registry.clear();
+    Summary.clear();
+    Generation.clear();
+    FreeSlots.clear();
+    FreeHead=0;
+    Order.clear();
+    OrderPos.clear();
+    liveTracks=0;
+    clearShared();
+    invalidateFrameIndex();
+    invalidatePickIndex();
     return 0;
 }
 
 vector<TrackPoint> MosquitoRegistry::getVectorOfTrackPoints(int ID)
 {
   vector<TrackPoint> idTrack;
-  if(ID<Registry.size() && ID>=0) 
-    idTrack=Registry[ID];
+  long slot=trackSlot(ID);
+  if(slot>=0)
+    idTrack=Registry[slot];
   return idTrack;   
 }
 
@@ -453,21 +993,25 @@ int MosquitoRegistry::addVectorOfTrackPoints(vector<TrackPoint> t, int ofx, int
      for(int i=0; i<t.size(); i++)
       t[i].move(ofx,ofy);
       
-    Registry.push_back(t);
-    int ID=Registry.size();
-    return ID;
+    long slot=newTrackSlot();
+    if(slot<0)
+     return -1;
+    Registry[slot].swap(t);
+    invalidateFrameIndex();
+    return trackID(slot);
 }
 
-bool MosquitoRegistry::addVectorOfTrackPointsToTrack(int n, vector<TrackPoint> t, int ofx /*= 0*/, int ofy /*= 0*/)
+bool MosquitoRegistry::addVectorOfTrackPointsToTrack(int ID, vector<TrackPoint> t, int ofx /*= 0*/, int ofy /*= 0*/)
 {
-    if(n<Registry.size())
+    long n=trackSlot(ID);
+    if(n>=0)
     {
     if(!(ofx==0 && ofy==0))
      for(int i=0; i<t.size(); i++)
       t[i].move(ofx,ofy);
     for(int i=0; i<t.size(); i++)
      Registry[n].push_back(t[i]);
-    sortTrack(n);
+    sortTrack(ID);
     return true;
     }
     return false;
@@ -475,48 +1019,74 @@ bool MosquitoRegistry::addVectorOfTrackPointsToTrack(int n, vector<TrackPoint> t
 
 int MosquitoRegistry::numOfTracks()
 {
-  return Registry.size();   
+  return liveTracks;
 }
 
 vector<vector<TrackPoint> > MosquitoRegistry::getRegistry()
 {
-  return Registry;
+  vector<vector<TrackPoint> > tracks;
+  tracks.reserve(liveTracks);
+  for(unsigned long k=0; k<Order.size(); k++)
+   if(OrderPos[Order[k]]==(long)k)
+    tracks.push_back(Registry[Order[k]]);
+  return tracks;
 }
 
 vector<int> MosquitoRegistry::findTrackID(double xi, double yi, double minDist, int fromFrame, int toFrame)
 {
+    // only the grid cells within minDist are searched, for equal distances the
+    // lowest track and point number wins as in a scan over the whole registry
     vector<int> ret;
     double dist=minDist;
     int n=-1;
     int m=-1;
-    for(unsigned long i=0; i<Registry.size();i++)
-    {
-        for(unsigned long j=0; j<Registry[i].size(); j++)
+    if(toFrame<=fromFrame || minDist<=0)
+     return ret;
+    updatePickIndex();
+    long long b0=max(fromFrame,0)/FRAMEINDEXBLOCK;
+    long long b1=max(toFrame-1,0)/FRAMEINDEXBLOCK;
+    long long cx0=(long long)floor((xi-minDist)/PICKCELLSIZE);
+    long long cx1=(long long)floor((xi+minDist)/PICKCELLSIZE);
+    long long cy0=(long long)floor((yi-minDist)/PICKCELLSIZE);
+    long long cy1=(long long)floor((yi+minDist)/PICKCELLSIZE);
+    for(long long b=b0; b<=b1; b++)
+     for(long long cx=cx0; cx<=cx1; cx++)
+      for(long long cy=cy0; cy<=cy1; cy++)
+      {
+       unordered_map<long long, vector<pair<unsigned long,unsigned long> > >::const_iterator it=pickCells.find(pickCellKey(b,cx,cy));
+       if(it==pickCells.end())
+        continue;
+       const vector<pair<unsigned long,unsigned long> > &e=it->second;
+       for(unsigned long k=0; k<e.size(); k++)
+       {
+        int i=e[k].first;
+        int j=e[k].second;
+        const TrackPoint &p=Registry[i][j];
+        if(p.frame>=fromFrame && p.frame<toFrame)
         {
-            if(Registry[i][j].frame>=fromFrame && Registry[i][j].frame<toFrame)
-            {
-                double d=sqrt(pow(xi-Registry[i][j].x,2)+pow(yi-Registry[i][j].y,2));
-                if(d<dist)
-                {
-                    n=i;
-                    m=j;
-                    dist=d;
-                }
-            }
-        }  
-    }
+         double d=sqrt(pow(xi-p.x,2)+pow(yi-p.y,2));
+         if(d<dist || (n!=-1 && d==dist && (i<n || (i==n && j<m))))
+         {
+          n=i;
+          m=j;
+          dist=d;
+         }
+        }
+       }
+      }
     if(n!=-1 && m!=-1)
     {
-     ret.push_back(n);
+     ret.push_back(trackID(n));
      ret.push_back(m);
     }
     return ret;
 }
 
-vector<cv::Point2f>  MosquitoRegistry::getSingleTrack(int ID)
+vector<cv::Point2f>  MosquitoRegistry::getSingleTrack(int trackId)
 {
      vector<cv::Point2f> temp;
-     if(ID<Registry.size() && ID>=0)
+     long ID=trackSlot(trackId);
+     if(ID>=0)
      {
       if(Registry[ID].size()>1)
       for(int j=0;j<Registry[ID].size();j++)
@@ -529,36 +1099,45 @@ vector<cv::Point2f>  MosquitoRegistry::getSingleTrack(int ID)
      return temp;
 }
 
-bool  MosquitoRegistry::removePointFromTrack(int n, int m, bool split_here /*= false */)
+bool  MosquitoRegistry::removePointFromTrack(int ID, int m, bool split_here /*= false */)
 {
- if(n<Registry.size())
+ long n=trackSlot(ID);
+ if(n>=0)
  {
+  invalidateTrack(n);
   if(m<Registry[n].size())
   {
    if(!split_here)
    {
     Registry[n].erase(Registry[n].begin()+m);
     if(Registry[n].size()==0)
-     Registry.erase(Registry.begin()+n);
+     eraseTrack(n);
    }
    else
    {
-    vector<TrackPoint> tmp=getVectorOfTrackPoints(n);
+    if(!trackSlotAvailable())
+    {
+     cerr<<"Error: the registry is full, track NOT split!\n";
+     return false;
+    }
+    vector<TrackPoint> tmp(Registry[n].begin()+m+1,Registry[n].end());
     Registry[n].erase(Registry[n].begin()+m,Registry[n].end());
-    tmp.erase(tmp.begin(),tmp.begin()+m+1);
     if(tmp.size()>0)
     {
      int newID=addVectorOfTrackPoints(tmp, 0, 0);
     }
    }
+   return true;
   }
  }
+ return false;
 }
 
 
-bool  MosquitoRegistry::addPointToTrack(int n, TrackPoint a, bool replace /*= false*/)
+bool  MosquitoRegistry::addPointToTrack(int ID, TrackPoint a, bool replace /*= false*/)
 {
- if(n<Registry.size())
+ long n=trackSlot(ID);
+ if(n>=0)
  {
    bool newframe=true;
    int other=-1;
@@ -568,6 +1147,7 @@ bool  MosquitoRegistry::addPointToTrack(int n, TrackPoint a, bool replace /*= fa
      newframe=false;
      other=i;
     }
+   invalidateTrack(n);
    if(replace && !newframe)
    {
      Registry[n][other]=a;
@@ -576,29 +1156,55 @@ bool  MosquitoRegistry::addPointToTrack(int n, TrackPoint a, bool replace /*= fa
    else if(newframe)
    {
      Registry[n].push_back(a);
-     sortTrack(n);
+     sortTrack(ID);
    } 
  }
  return false;
 }
 
-bool MosquitoRegistry::joinTracks(int n,int m)
+bool MosquitoRegistry::joinTracks(int nID,int mID)
 {
+ // the joined track always keeps the ID of track n
+ long n=trackSlot(nID);
+ long m=trackSlot(mID);
+ if(n>=0 && m>=0 && m!=n)
+ {
+  if(mergeTracks(n,m))
+  {
+   if(Registry[n].size()==0)
+    Registry[n].swap(Registry[m]);
+   eraseTrack(m);
+   return true;
+  }
+  return false;
+ }
+ cerr<<"Track NOT joined!\n";
+ return false;
+}
+
+bool MosquitoRegistry::mergeTracks(int n,int m)
+{
+ // joins track m into track n (or into the lower index of both if they overlap in time),
+ // the other track is left empty so that the caller can remove it
  if(n<Registry.size() && m<Registry.size() && m!=n && m>=0 && n>=0)
  {
+  invalidateTrack(n);
+  invalidateTrack(m);
   bool intersection=false;
+  vector<int> fm;
+  for(unsigned int j=0; j<Registry[m].size(); j++)
+   fm.push_back(Registry[m][j].frame);
+  sort(fm.begin(), fm.end());
   for(unsigned int i=0; i<Registry[n].size(); i++)
-   for(unsigned int j=0; j<Registry[m].size(); j++)
-    if(Registry[n][i].frame == Registry[m][j].frame)
-    { 
-      intersection=true;
-      break;
-    }
+   if(binary_search(fm.begin(), fm.end(), Registry[n][i].frame))
+   {
+     intersection=true;
+     break;
+   }
   if(!intersection)
   {
-   vector<TrackPoint> tmp=getVectorOfTrackPoints(m);
-   addVectorOfTrackPointsToTrack(n, tmp);
-   Registry.erase(Registry.begin()+m);
+   addVectorOfTrackPointsToTrack(trackID(n), Registry[m]);
+   vector<TrackPoint>().swap(Registry[m]);
    return true;
   }
   else
@@ -779,12 +1385,12 @@ bool MosquitoRegistry::joinTracks(int n,int m)
         t.push_back(tmpT[i][selectedTrack[i]]);
        if(m>n)
        {
-        Registry.erase(Registry.begin()+m);
+        vector<TrackPoint>().swap(Registry[m]);
         Registry[n].swap(t);
        }
        else
        {
-        Registry.erase(Registry.begin()+n);
+        vector<TrackPoint>().swap(Registry[n]);
         Registry[m].swap(t);
        }
        cerr<<"Track successfully joined!\n";
@@ -804,26 +1410,33 @@ bool MosquitoRegistry::joinTracks(int n,int m)
  return false;
 }
 
-bool MosquitoRegistry::deleteTrack(int n)
+bool MosquitoRegistry::deleteTrack(int ID)
 {
- if(n<Registry.size())
+ long n=trackSlot(ID);
+ if(n>=0)
  {
-   Registry.erase(Registry.begin()+n);
+   eraseTrack(n);
    return true;
  }
  else
   return false;
 }
 
-bool MosquitoRegistry::splitTrack(int n,int m)
+bool MosquitoRegistry::splitTrack(int ID,int m)
 {
- if(n<Registry.size())
+ long n=trackSlot(ID);
+ if(n>=0)
  {
-  if(m<Registry[n].size()-1)
+  if(m>=0 && m<(int)Registry[n].size()-1)
   {
-    vector<TrackPoint> tmp=getVectorOfTrackPoints(n);
+    if(!trackSlotAvailable())
+    {
+     cerr<<"Error: the registry is full, track NOT split!\n";
+     return false;
+    }
+    vector<TrackPoint> tmp(Registry[n].begin()+m+1,Registry[n].end());
     Registry[n].erase(Registry[n].begin()+m+1,Registry[n].end());
-    tmp.erase(tmp.begin(),tmp.begin()+m+1);
+    invalidateTrack(n);
     if(tmp.size()>0)
     {
      int newID=addVectorOfTrackPoints(tmp, 0, 0);
@@ -833,157 +1446,129 @@ bool MosquitoRegistry::splitTrack(int n,int m)
  return true;
 }
 
-bool MosquitoRegistry::sortTrack(int n)
+bool MosquitoRegistry::sortTrack(int ID)
 {
- if(n<Registry.size())
+ long n=trackSlot(ID);
+ if(n>=0)
  {
   sort(Registry[n].begin(), Registry[n].end(),
            [](TrackPoint a, TrackPoint b) { return a.frame < b.frame; });
+  invalidateTrack(n);
  }
  return true;
 }
 
-bool MosquitoRegistry::autoJoinTracks(double maxiDistT, unsigned long maxTempDist, int remTooShort /*= 3*/, double angle /*= 0.5*/)
+void MosquitoRegistry::findTrackSuccessors(unsigned long i, unsigned long k, const vector<pair<int,unsigned long> > &starts, double maxiDistT, unsigned long maxTempDist, vector<trackConnection> &c)
 {
- cerr<<"Step1:\n";
- int n=0;
- QProgressDialog* DisplayProgress;
- bool haveDialog=true;
- DisplayProgress=new QProgressDialog("Autojoin Step 1 ...", "Cancel", 0, Registry.size());
- DisplayProgress->setWindowModality(Qt::WindowModal);
-
- for(unsigned int i=0; i<Registry.size(); i++)
- {
- DisplayProgress->setValue(i);
- if (DisplayProgress->wasCanceled())
+ // tracks starting less than maxTempDist frames after point k of track i
+ // and not further away than maxiDistT per frame
+ double stopx=Registry[i][k].x;
+ double stopy=Registry[i][k].y;
+ long int stopi=Registry[i][k].frame;
+ vector<pair<int,unsigned long> >::const_iterator it=upper_bound(starts.begin(), starts.end(),
+                                                     make_pair((int)stopi,numeric_limits<unsigned long>::max()));
+ for(; it!=starts.end() && double(it->first)-stopi<maxTempDist; it++)
  {
-  DisplayProgress->setValue(Registry.size());
-  delete DisplayProgress;
-  haveDialog=false;
-  break;
+  unsigned long j=it->second;
+  if(j==i)
+   continue;
+  double dist=sqrt(pow(Registry[j][0].x-stopx,2)+pow(Registry[j][0].y-stopy,2));
+  if(dist<maxiDistT*double(it->first-stopi))
+  {
+   trackConnection tmp;
+   tmp.cost=dist;
+   tmp.source=i;
+   tmp.target=j;
+   c.push_back(tmp);
+  }
  }
- if(TrackLength(i)>1)
+}
+
+int MosquitoRegistry::joinConnectedTracks(vector<trackConnection> c, bool oneToOne)
+{
+ // applies the connections ordered by cost, with oneToOne every track gets at most
+ // one successor and one predecessor; joined tracks are removed at the end
+ sort(c.begin(), c.end(), sortTrackConnectionByCost);
+ unsigned long nT=Registry.size();
+ vector<unsigned long> parent(nT);
+ for(unsigned long i=0; i<nT; i++)
+  parent[i]=i;
+ vector<bool> hasSuccessor(nT,false);
+ vector<bool> hasPredecessor(nT,false);
+ vector<bool> absorbed(nT,false);
+ int n=0;
+ for(unsigned long k=0; k<c.size(); k++)
  {
-  double startx=Registry[i][0].x;
-  double starty=Registry[i][0].y;
-  long int starti=Registry[i][0].frame;
-  double stopx=Registry[i][Registry[i].size()-1].x;
-  double stopy=Registry[i][Registry[i].size()-1].y;
-  long int stopi=Registry[i][Registry[i].size()-1].frame;
-  vector<int> candidates;
-  vector<double> dist;
-  vector<int> distT;
-  for(unsigned int j=0; j<Registry.size(); j++)
-   if(i!=j)
-    if(TrackLength(j)>1)
+  if(oneToOne)
   {
-    if(double(Registry[j][0].frame)-stopi<maxTempDist && Registry[j][0].frame>stopi)
-     if(sqrt(pow(Registry[j][0].x-stopx,2)+pow(Registry[j][0].y-stopy,2))<maxiDistT*double(Registry[j][0].frame-stopi))
-    {
-      candidates.push_back(j);
-      dist.push_back(sqrt(pow(Registry[j][0].x-stopx,2)+pow(Registry[j][0].y-stopy,2)));
-      distT.push_back((int)Registry[j][0].frame-stopi);
-    }
-    if(starti-double(Registry[j][Registry[j].size()-1].frame)<maxTempDist &&  starti>Registry[j][Registry[j].size()-1].frame) 
-       if(sqrt(pow(Registry[j][Registry[j].size()-1].x-startx,2)+pow(Registry[j][Registry[j].size()-1].y-starty,2))<maxiDistT*double(starti-Registry[j][Registry[j].size()-1].frame))
-    {
-      candidates.push_back(j);
-      dist.push_back(sqrt(pow(Registry[j][Registry[j].size()-1].x-startx,2)+pow(Registry[j][Registry[j].size()-1].y-starty,2)));
-      distT.push_back((int)Registry[j][Registry[j].size()-1].frame-starti);
-    }
+   if(hasSuccessor[c[k].source] || hasPredecessor[c[k].target])
+    continue;
   }
-  double distend=99999;
-  double diststart=99999;
-  int iend=-1; 
-  int istart=-1;
-  
-  for(unsigned j=0; j<candidates.size(); j++)
+  unsigned long ri=findTrackRoot(parent,c[k].source);
+  unsigned long rj=findTrackRoot(parent,c[k].target);
+  if(ri==rj)
+   continue;
+  if(mergeTracks(ri,rj))
   {
-   if(distT[j]>0)
+   hasSuccessor[c[k].source]=true;
+   hasPredecessor[c[k].target]=true;
+   if(Registry[rj].size()==0)
    {
-    if(dist[j]<distend)
-    {
-     distend=dist[j];
-     iend=j;
-    }
+    parent[rj]=ri;
+    absorbed[rj]=true;
    }
    else
    {
-    if(dist[j]<diststart)
-    {
-     diststart=dist[j];
-     istart=j;
-    }   
+    parent[ri]=rj;
+    absorbed[ri]=true;
    }
+   n++;
   }
-  
-  if(istart!=-1 && iend!=-1)
-  {
-   if(candidates[istart]>candidates[iend])
-   {
-    if(i<candidates[istart])
-    {
-     bool ret=joinTracks(i,candidates[istart]);
-     if(ret) n++;
-     ret=joinTracks(i,candidates[iend]);
-     if(ret) n++;
-    }
-    else
-    {
-     bool ret=joinTracks(i,candidates[istart]);
-     if(ret)
-     {
-      n++;
-      ret=joinTracks(i-1,candidates[iend]-1);
-      if(ret)
-       n++;
-     }
-     else
-     {
-      ret=joinTracks(i,candidates[iend]);
-      if(ret)
-       n++;
-     }
-    }
-   }
-   else
-   {
-    if(i<candidates[iend])
-    {
-     bool ret=joinTracks(i,candidates[iend]);
-     if(ret) n++;
-     ret=joinTracks(i,candidates[istart]);
-     if(ret) n++;
-    }
-    else
-    {
-     bool ret=joinTracks(i,candidates[iend]);
-     if(ret)
-     {
-      n++;
-      ret=joinTracks(i-1,candidates[istart]-1);
-      if(ret)n++;
-     }
-     else
-     {
-      ret=joinTracks(i,candidates[istart]);
-      if(ret) n++;
-     }
-    }
-   }
-  }
-  else if(istart!=-1)
-  {
-   bool ret=joinTracks(i,candidates[istart]);
-   if(ret)n++;
-  }
-  else if(iend!=-1)
+ }
+ if(n>0)
+ {
+  for(unsigned long i=0; i<nT; i++)
+   if(absorbed[i])
+    eraseTrack(i);
+  invalidateFrameIndex();
+ }
+ return n;
+}
+
+bool MosquitoRegistry::autoJoinTracks(double maxiDistT, unsigned long maxTempDist, int remTooShort /*= 3*/, double angle /*= 0.5*/)
+{
+ cerr<<"Step1:\n";
+ int n=0;
+ QProgressDialog* DisplayProgress;
+ bool haveDialog=true;
+ DisplayProgress=new QProgressDialog("Autojoin Step 1 ...", "Cancel", 0, Registry.size());
+ DisplayProgress->setWindowModality(Qt::WindowModal);
+ unsigned long progressStep=Registry.size()/100+1;
+
+ vector<pair<int,unsigned long> > starts;
+ for(unsigned long i=0; i<Registry.size(); i++)
+  if(Registry[i].size()>1)
+   starts.push_back(make_pair(Registry[i][0].frame,i));
+ sort(starts.begin(), starts.end());
+
+ vector<trackConnection> connections;
+ for(unsigned long i=0; i<Registry.size(); i++)
+ {
+ if(i%progressStep==0)
+ {
+  DisplayProgress->setValue(i);
+  if (DisplayProgress->wasCanceled())
   {
-   bool ret=joinTracks(i,candidates[iend]);
-   if(ret)n++;
+   DisplayProgress->setValue(Registry.size());
+   delete DisplayProgress;
+   haveDialog=false;
+   break;
   }
  }
+ if(Registry[i].size()>1)
+  findTrackSuccessors(i, Registry[i].size()-1, starts, maxiDistT, maxTempDist, connections);
  }
+ n=joinConnectedTracks(connections,true);
  if(haveDialog)
  {
   DisplayProgress->setValue(Registry.size());
@@ -997,127 +1582,32 @@ bool MosquitoRegistry::autoJoinTracks(double maxiDistT, unsigned long maxTempDis
  haveDialog=true;
  DisplayProgress=new QProgressDialog("Autojoin Step 1a ...", "Cancel", 0, Registry.size());
  DisplayProgress->setWindowModality(Qt::WindowModal);
+ progressStep=Registry.size()/100+1;
 
- for(unsigned int i=0; i<Registry.size(); i++)
- {
- DisplayProgress->setValue(i);
- if (DisplayProgress->wasCanceled())
+ starts.clear();
+ for(unsigned long i=0; i<Registry.size(); i++)
+  if(Registry[i].size()>1)
+   starts.push_back(make_pair(Registry[i][0].frame,i));
+ sort(starts.begin(), starts.end());
+
+ connections.clear();
+ for(unsigned long i=0; i<Registry.size(); i++)
  {
-  DisplayProgress->setValue(Registry.size());
-  delete DisplayProgress;
-  haveDialog=false;
-  break;
- }
- if(TrackLength(i)>2)
+ if(i%progressStep==0)
  {
-  double stopx=Registry[i][Registry[i].size()-2].x;
-  double stopy=Registry[i][Registry[i].size()-2].y;
-  long int stopi=Registry[i][Registry[i].size()-2].frame;
-  vector<int> candidates;
-  vector<double> dist;
-  vector<int> distT;
-  for(unsigned int j=0; j<Registry.size(); j++)
-   if(i!=j)
-    if(TrackLength(j)>1)
-  {
-    if(double(Registry[j][0].frame)-stopi<maxTempDist && Registry[j][0].frame>stopi)
-     if(sqrt(pow(Registry[j][0].x-stopx,2)+pow(Registry[j][0].y-stopy,2))<maxiDistT*double(Registry[j][0].frame-stopi))
-    {
-      candidates.push_back(j);
-      dist.push_back(sqrt(pow(Registry[j][0].x-stopx,2)+pow(Registry[j][0].y-stopy,2)));
-      distT.push_back((int)Registry[j][0].frame-stopi);
-    }
-  }
-  double distend=99999;
-  double diststart=99999;
-  int iend=-1; 
-  int istart=-1;
-  
-  for(unsigned j=0; j<candidates.size(); j++)
-  {
-   if(distT[j]>0)
-   {
-    if(dist[j]<distend)
-    {
-     distend=dist[j];
-     iend=j;
-    }
-   }
-   else
-   {
-    if(dist[j]<diststart)
-    {
-     diststart=dist[j];
-     istart=j;
-    }   
-   }
-  }
-  
-  if(istart!=-1 && iend!=-1)
-  {
-   if(candidates[istart]>candidates[iend])
-   {
-    if(i<candidates[istart])
-    {
-     bool ret=joinTracks(i,candidates[istart]);
-     if(ret) n++;
-     ret=joinTracks(i,candidates[iend]);
-     if(ret) n++;
-    }
-    else
-    {
-     bool ret=joinTracks(i,candidates[istart]);
-     if(ret)
-     {
-      n++;
-      ret=joinTracks(i-1,candidates[iend]-1);
-      if(ret) n++;
-     }
-     else
-     {
-      ret=joinTracks(i,candidates[iend]);
-      if(ret) n++;     
-     }
-    }
-   }
-   else
-   {
-    if(i<candidates[iend])
-    {
-     bool ret=joinTracks(i,candidates[iend]);
-     if(ret)n++;
-     ret=joinTracks(i,candidates[istart]);
-     if(ret)n++;
-    }
-    else
-    {
-     bool ret=joinTracks(i,candidates[iend]);
-     if(ret)
-     {
-      n++;
-      ret=joinTracks(i-1,candidates[istart]-1);
-      if(ret) n++;
-     }
-     else
-     {
-      ret=joinTracks(i,candidates[istart]);
-      if(ret) n++;
-     }
-    }
-   }
-  }
-  else if(istart!=-1)
-  {
-   bool ret=joinTracks(i,candidates[istart]);
-   if(ret)n++;
-  }
-  else if(iend!=-1)
+  DisplayProgress->setValue(i);
+  if (DisplayProgress->wasCanceled())
   {
-   bool ret=joinTracks(i,candidates[iend]);
-   if(ret)n++;
+   DisplayProgress->setValue(Registry.size());
+   delete DisplayProgress;
+   haveDialog=false;
+   break;
   }
  }
+ if(Registry[i].size()>2)
+  findTrackSuccessors(i, Registry[i].size()-2, starts, maxiDistT, maxTempDist, connections);
  }
+ n=joinConnectedTracks(connections,true);
  if(haveDialog)
  {
   DisplayProgress->setValue(Registry.size());
@@ -1131,10 +1621,16 @@ bool MosquitoRegistry::autoJoinTracks(double maxiDistT, unsigned long maxTempDis
  haveDialog=true;
   DisplayProgress=new QProgressDialog("Autojoin Step 2 ...", "Cancel", 0, Registry.size());
  DisplayProgress->setWindowModality(Qt::WindowModal);
-
- for(unsigned int i=0; i<Registry.size(); i++)
+ progressStep=Registry.size()/100+1;
+
+ // overlapping tracks are looked up in the frame index, the distances are
+ // calculated in parallel for one block of tracks between progress updates
+ connections.clear();
+ updateFrameIndex();
+ long nT=Registry.size();
+ for(long i0=0; i0<nT; i0+=progressStep)
  {
-  DisplayProgress->setValue(i);
+ DisplayProgress->setValue(i0);
  if (DisplayProgress->wasCanceled())
  {
   DisplayProgress->setValue(Registry.size());
@@ -1142,33 +1638,46 @@ bool MosquitoRegistry::autoJoinTracks(double maxiDistT, unsigned long maxTempDis
   haveDialog=false;
   break;
  }
- 
-  for(unsigned int j=0; j<Registry.size(); j++)
+ long i1=min(nT,i0+(long)progressStep);
+#pragma omp parallel
+ {
+  vector<trackConnection> connectionsPrivate;
+  #pragma omp for nowait schedule(dynamic)
+  for(long i=i0; i<i1; i++)
   {
-   if(j!=i)
+   if(Registry[i].size()==0)
+    continue;
+   vector<unsigned long> ids=tracksInFrameRange(Registry[i][0].frame,Registry[i][Registry[i].size()-1].frame,1);
+   for(unsigned long k=0; k<ids.size(); k++)
    {
+    unsigned long j=ids[k];
+    if(j<=i)
+     continue;
     if(Registry[i][0].frame<=Registry[j][Registry[j].size()-1].frame && 
        Registry[i][Registry[i].size()-1].frame>=Registry[j][0].frame)
-     {
-      vector<double> distance=lineLineDistance(i,j);
-      if(distance.size()==4)
-       if(distance[3]>1)
-      {
+    {
+     vector<double> distance=lineLineDistance(i,j);
+     if(distance.size()==4)
+      if(distance[3]>1)
        if(distance[1]<maxiDistT)
         if(distance[0]<3)
         {
-         if(joinTracks(i,j))
-         {
-          if(j<i)i--;
-          n++;
-          break;
-         }
+         trackConnection tmp;
+         tmp.cost=distance[2];
+         tmp.source=i;
+         tmp.target=j;
+         connectionsPrivate.push_back(tmp);
         }
-      }
-     }
+    }
    }
-  } 
+  }
+  #pragma omp critical
+  {
+   connections.insert(connections.end(),connectionsPrivate.begin(),connectionsPrivate.end());
+  }
+ }
  }
+ n=joinConnectedTracks(connections,false);
  if(haveDialog)
  {
   DisplayProgress->setValue(Registry.size());
@@ -1182,22 +1691,29 @@ bool MosquitoRegistry::autoJoinTracks(double maxiDistT, unsigned long maxTempDis
  haveDialog=true;
  DisplayProgress=new QProgressDialog("Autojoin Step 3 ...", "Cancel", 0, Registry.size());
  DisplayProgress->setWindowModality(Qt::WindowModal);
+ progressStep=Registry.size()/100+1;
  
  for(unsigned int i=0; i<Registry.size(); i++)
  {
- DisplayProgress->setValue(i);
- if (DisplayProgress->wasCanceled())
+ if(i%progressStep==0)
  {
-  DisplayProgress->setValue(Registry.size());
-  delete DisplayProgress;
-  haveDialog=false;
-  break;
+  DisplayProgress->setValue(i);
+  if (DisplayProgress->wasCanceled())
+  {
+   DisplayProgress->setValue(Registry.size());
+   delete DisplayProgress;
+   haveDialog=false;
+   break;
+  }
  }
- if(TrackLength(i)>1)
+ if(Registry[i].size()>1)
  {
   vector<TrackPoint> filtered=removeSpikes(Registry[i],angle);
   if(filtered.size()<Registry[i].size())
+  {
    filtered.swap(Registry[i]);
+   invalidateTrack(i);
+  }
  }
  }
  if(haveDialog)
@@ -1267,12 +1783,12 @@ vector<TrackPoint> MosquitoRegistry::removeSpikes(vector<TrackPoint> t, double a
 int MosquitoRegistry::removeTooShort(int x)
 {
  int n=0;
- int orig=(int)Registry.size();
- Registry.erase(
-  std::remove_if(Registry.begin(), Registry.end(),
-        [x](const vector<TrackPoint> & t) { return (t.size()<x); }),
-    Registry.end());
- n=orig-(int)Registry.size();
+ for(unsigned long i=0; i<Registry.size(); i++)
+  if(OrderPos[i]>=0 && (int)Registry[i].size()<x)
+  {
+   eraseTrack(i);
+   n++;
+  }
  return n;
 }
 
@@ -1288,43 +1804,20 @@ vector<double> MosquitoRegistry::lineLineDistance(unsigned int n,unsigned int m)
     fn.push_back(Registry[m][j].frame);
    sort( fn.begin(), fn.end() );
    fn.erase( unique( fn.begin(), fn.end() ), fn.end() );
-   vector<vector<TrackPoint> > tmpTA;
-   vector<vector<TrackPoint> > tmpTB;
-   vector<double> distances;
-   for(unsigned int f=0; f<fn.size(); f++)
-   {
-    vector<TrackPoint> pt;
-    tmpTA.push_back(pt);
-    tmpTB.push_back(pt);
-    distances.push_back(-1);
-   }
+   vector<vector<TrackPoint> > tmpTA(fn.size());
+   vector<vector<TrackPoint> > tmpTB(fn.size());
+   vector<double> distances(fn.size(),-1);
    
    for(unsigned int i=0; i<Registry[n].size(); i++)
    {
-    int cf=Registry[n][i].frame;
-    int addr=-1;
-    for(unsigned int j=0; j<fn.size(); j++)
-     if(fn[j]==cf)
-      {
-        addr=j;
-        break;
-      }
-      if(addr!=-1)
-       tmpTA[addr].push_back(Registry[n][i]);  
+    int addr=lower_bound(fn.begin(), fn.end(), (unsigned long)Registry[n][i].frame)-fn.begin();
+    tmpTA[addr].push_back(Registry[n][i]);  
    }
    
    for(unsigned int i=0; i<Registry[m].size(); i++)
    {
-    int cf=Registry[m][i].frame;
-    int addr=-1;
-    for(unsigned int j=0; j<fn.size(); j++)
-     if(fn[j]==cf)
-      {
-        addr=j;
-        break;
-      }
-    if(addr!=-1)
-     tmpTB[addr].push_back(Registry[m][i]);  
+    int addr=lower_bound(fn.begin(), fn.end(), (unsigned long)Registry[m][i].frame)-fn.begin();
+    tmpTB[addr].push_back(Registry[m][i]);  
    }
    
    int startfn=Registry[n][0].frame;
@@ -1335,18 +1828,12 @@ vector<double> MosquitoRegistry::lineLineDistance(unsigned int n,unsigned int m)
     stopfn=Registry[m][Registry[m].size()-1].frame;
    int imin=-1;
    int imax=-1;
-   for(unsigned int j=0; j<fn.size(); j++)
-    if(fn[j]==startfn)
-     {
-       imin=j;
-       break;
-     }
-   for(unsigned int j=0; j<fn.size(); j++)
-    if(fn[j]==stopfn)
-     {
-       imax=j;
-       break;
-     }     
+   vector<unsigned long>::iterator it=lower_bound(fn.begin(), fn.end(), (unsigned long)startfn);
+   if(it!=fn.end() && *it==(unsigned long)startfn)
+    imin=it-fn.begin();
+   it=lower_bound(fn.begin(), fn.end(), (unsigned long)stopfn);
+   if(it!=fn.end() && *it==(unsigned long)stopfn)
+    imax=it-fn.begin();
    if(imax!=-1 && imin!=-1 && imin<=imax)
     {
      for(unsigned int f=imin; f<=imax; f++)
@@ -1421,168 +1908,134 @@ vector<double> MosquitoRegistry::lineLineDistance(unsigned int n,unsigned int m)
  return ret;
 }  
 
-bool MosquitoRegistry::updateMosquitoPointer(MosquitoesInSeq* in)
+bool MosquitoRegistry::linkPositions(MosquitoesInSeq* in)
 {
+ // only points without a slot (e.g. loaded from file) have to be searched,
+ // linked points keep their slot as positions are added and removed
  if(in)
  {
   for(unsigned int i=0; i<Registry.size(); i++)
    for(unsigned int j=0; j<Registry[i].size(); j++)
-   {
-    MosquitoesInFrame* pframe=in->mosqInFrameI(Registry[i][j].frame);
-    if(pframe)
+    if(Registry[i][j].slot<0)
     {
-     MosquitoPosition* ppos=pframe->mosqi(Registry[i][j].x, Registry[i][j].y);
-     if(ppos)
+     MosquitoesInFrame* pframe=in->mosqInFrameI(Registry[i][j].frame);
+     if(pframe)
      {
-      Registry[i][j].setMosquitoPointer(ppos);
+      MosquitoPosition* ppos=pframe->mosqi(Registry[i][j].x, Registry[i][j].y);
+      if(ppos)
+       Registry[i][j].setSlot(ppos->getSlot());
      }
     }
-   }
   return true;
  }
  else
   return false;
 }
 
-bool MosquitoRegistry::connectRestingTracks(int maxDT, double maxDX)
+MosquitoPosition* MosquitoRegistry::positionOfPoint(MosquitoesInSeq* in, int ID, unsigned long m)
 {
- vector<vector<int> > possibleRests;
- for(int i=0; i<Registry.size(); i++)
- { 
-   if(Registry[i].size()>1)
-   {
-    double ax=Registry[i][Registry[i].size()-1].x;
-    double ay=Registry[i][Registry[i].size()-1].y;
-    int af=Registry[i][Registry[i].size()-1].frame;
-    for(int j=0; j<Registry.size(); j++)
-     if(i!=j)
-      if(Registry[j].size()>1)
-     {
-      double bx=Registry[j][Registry[j].size()-1].x;
-      double by=Registry[j][Registry[j].size()-1].y;
-      int bf=Registry[j][Registry[j].size()-1].frame;
-      double dist=sqrt(pow(ax-bx,2)+pow(ay-by,2));
-      int dtime=bf-af;
-      if(dist<maxDX && dtime>0)
-      {
-       vector<int> tmp;
-       tmp.push_back(i);
-       tmp.push_back(j);
-       possibleRests.push_back(tmp);
-      }
-     }
-   }
- }
- vector<int> startIDs;
- vector<int> stopIDs;
- vector<int> multipleStartIDs;
- vector<int> multipleStopIDs;
- for(int i=0; i<possibleRests.size(); i++)
+ long n=trackSlot(ID);
+ if(!in || n<0 || m>=Registry[n].size())
+  return nullptr;
+ TrackPoint& p=Registry[n][m];
+ MosquitoesInFrame* pframe=in->mosqInFrameI(p.frame);
+ if(!pframe)
+  return nullptr;
+ MosquitoPosition* ppos=nullptr;
+ if(p.slot>=0)
+  ppos=pframe->mosqBySlot(p.slot);
+ // the slot belongs to a different set of positions, e.g. after reloading them
+ if(ppos && sqrt(pow(ppos->getX()-p.x,2)+pow(ppos->getY()-p.y,2))>=3)
+  ppos=nullptr;
+ if(!ppos)
  {
-  int found=0;
-  for(int j=0; j<startIDs.size(); j++)
-   if(startIDs[j]==possibleRests[i][0])
-    found++;
-  if(found==0)
-   startIDs.push_back(possibleRests[i][0]);
-  else if(found>1)
-  {
-   int found2=0;
-   for(int j=0; j<multipleStartIDs.size(); j++)
-    if(multipleStartIDs[j]==possibleRests[i][0])
-     found2++;
-   if(found2==0)
-    multipleStartIDs.push_back(possibleRests[i][0]);
-  }
+  ppos=pframe->mosqi(p.x, p.y);
+  p.slot = ppos ? (int)ppos->getSlot() : -1;
  }
+ return ppos;
+}
 
- for(int i=0; i<possibleRests.size(); i++)
- {
-  int found=0;
-  for(int j=0; j<stopIDs.size(); j++)
-   if(stopIDs[j]==possibleRests[i][1])
-    found++;
-  if(found==0)
-   stopIDs.push_back(possibleRests[i][1]);
-  else if(found>1)
+bool MosquitoRegistry::connectRestingTracks(int maxDT, double maxDX)
+{
+ // track ends are hashed into a grid with cells of size maxDX, so only tracks
+ // ending in neighbouring cells have to be compared
+ if(maxDX<=0)
+  return true;
+ unordered_map<unsigned long long, vector<unsigned long> > grid;
+ for(unsigned long i=0; i<Registry.size(); i++)
+  if(Registry[i].size()>1)
   {
-   int found2=0;
-   for(int j=0; j<multipleStopIDs.size(); j++)
-    if(multipleStopIDs[j]==possibleRests[i][1])
-     found2++;
-   if(found2==0)
-    multipleStopIDs.push_back(possibleRests[i][1]);
+   long long cx=(long long)floor(Registry[i][Registry[i].size()-1].x/maxDX);
+   long long cy=(long long)floor(Registry[i][Registry[i].size()-1].y/maxDX);
+   grid[gridKey(cx,cy)].push_back(i);
   }
- }
- 
- if(multipleStopIDs.size()==0 && multipleStartIDs.size()==0)
+ vector<unsigned long long> cells;
+ for(unordered_map<unsigned long long, vector<unsigned long> >::iterator it=grid.begin(); it!=grid.end(); it++)
+  cells.push_back(it->first);
+
+ vector<trackConnection> possibleRests;
+#pragma omp parallel
  {
-  for(int i=0; i<possibleRests.size(); i++)
+  vector<trackConnection> restsPrivate;
+  #pragma omp for nowait schedule(dynamic)
+  for(long c=0; c<(long)cells.size(); c++)
   {
-   cerr<<i<<":"<<possibleRests[i][0]<<"->"<<possibleRests[i][1]<<"\n";
+   const vector<unsigned long> &tracks=grid.find(cells[c])->second;
+   long long cx=(long long)floor(Registry[tracks[0]][Registry[tracks[0]].size()-1].x/maxDX);
+   long long cy=(long long)floor(Registry[tracks[0]][Registry[tracks[0]].size()-1].y/maxDX);
+   for(long long dx=-1; dx<=1; dx++)
+    for(long long dy=-1; dy<=1; dy++)
+    {
+     unordered_map<unsigned long long, vector<unsigned long> >::const_iterator other=grid.find(gridKey(cx+dx,cy+dy));
+     if(other==grid.end())
+      continue;
+     for(unsigned long k=0; k<tracks.size(); k++)
+     {
+      unsigned long i=tracks[k];
+      double ax=Registry[i][Registry[i].size()-1].x;
+      double ay=Registry[i][Registry[i].size()-1].y;
+      int af=Registry[i][Registry[i].size()-1].frame;
+      for(unsigned long l=0; l<other->second.size(); l++)
+      {
+       unsigned long j=other->second[l];
+       if(i==j)
+        continue;
+       double bx=Registry[j][Registry[j].size()-1].x;
+       double by=Registry[j][Registry[j].size()-1].y;
+       int bf=Registry[j][Registry[j].size()-1].frame;
+       double dist=sqrt(pow(ax-bx,2)+pow(ay-by,2));
+       int dtime=bf-af;
+       if(dist<maxDX && dtime>0)
+       {
+        trackConnection tmp;
+        tmp.cost=dist;
+        tmp.source=i;
+        tmp.target=j;
+        restsPrivate.push_back(tmp);
+       }
+      }
+     }
+    }
   }
-  for(int i=0; i<possibleRests.size(); i++)
+  #pragma omp critical
   {
-   bool ret=joinTracks(possibleRests[i][0],possibleRests[i][1]);
-   for(int j=i+1; j<possibleRests.size(); j++)
-   {
-    if(possibleRests[j][0]==possibleRests[i][1])possibleRests[j][0]=possibleRests[i][1];
-    if(possibleRests[j][0]>possibleRests[i][1])possibleRests[j][0]--;
-    if(possibleRests[j][1]>possibleRests[i][1])possibleRests[j][1]--;
-   }
-  }  
+   possibleRests.insert(possibleRests.end(),restsPrivate.begin(),restsPrivate.end());
+  }
  }
- else
+ sort(possibleRests.begin(), possibleRests.end(), sortTrackConnectionByCost);
+ for(unsigned long i=0; i<possibleRests.size(); i++)
  {
-  for(int i=0; i<possibleRests.size(); i++)
-  {
-   int found=0;
-   for(int j=0; j<multipleStopIDs.size(); j++)
-    if(multipleStopIDs[j]==possibleRests[i][1])
-     found++;
-   for(int j=0; j<multipleStartIDs.size(); j++)
-    if(multipleStartIDs[j]==possibleRests[i][0])
-     found++;
-   if(found==0)
-    cerr<<i<<":"<<possibleRests[i][0]<<"->"<<possibleRests[i][1]<<"\n";
-  }
-  for(int i=0; i<possibleRests.size(); i++)
-  {
-   int found=0;
-   for(int j=0; j<multipleStopIDs.size(); j++)
-    if(multipleStopIDs[j]==possibleRests[i][1])
-     found++;
-   for(int j=0; j<multipleStartIDs.size(); j++)
-    if(multipleStartIDs[j]==possibleRests[i][0])
-     found++;
-   if(found==0)
-   {
-    joinTracks(possibleRests[i][0],possibleRests[i][1]);
-    for(int j=i+1; j<possibleRests.size(); j++)
-    {
-     if(possibleRests[j][0]==possibleRests[i][1])possibleRests[j][0]=possibleRests[i][1];
-     if(possibleRests[j][0]>possibleRests[i][1])possibleRests[j][0]--;
-     if(possibleRests[j][1]>possibleRests[i][1])possibleRests[j][1]--;
-    }
-    for(int j=0; j<multipleStartIDs.size(); j++)
-    {
-     if(multipleStartIDs[j]==possibleRests[i][1])multipleStartIDs[j]=possibleRests[i][1];
-     if(multipleStartIDs[j]>possibleRests[i][1])multipleStartIDs[j]--;
-    }
-    for(int j=0; j<multipleStopIDs.size(); j++)
-    {
-     if(multipleStopIDs[j]==possibleRests[i][1])multipleStopIDs[j]=possibleRests[i][1];
-     if(multipleStopIDs[j]>possibleRests[i][1])multipleStopIDs[j]--;
-    }
-   }
-  }
+  cerr<<i<<":"<<possibleRests[i].source<<"->"<<possibleRests[i].target<<"\n";
  }
+ joinConnectedTracks(possibleRests,false);
+ return true;
 }
 
-vector<vector<double> > MosquitoRegistry::getDataForTrack(unsigned long n, int dataType)
+vector<vector<double> > MosquitoRegistry::getDataForTrack(unsigned long ID, int dataType)
 {
  vector<vector<double> > tmp;
- if(dataType==0)
+ long n=trackSlot(ID);
+ if(dataType==0 && n>=0)
  {
    for(int i=0; i<Registry[n].size()-1; i++)
    {
@@ -1607,7 +2060,10 @@ bool MosquitoRegistry::fixTime(MosquitoesInSeq* in)
 {
  if(in)
  {
+  clearShared();
   for(unsigned int i=0; i<Registry.size(); i++)
+  {
+   Summary[i].valid=false;
    for(unsigned int j=0; j<Registry[i].size(); j++)
    {
     MosquitoesInFrame* pframe=in->mosqInFrameI(Registry[i][j].frame);
@@ -1622,6 +2078,7 @@ bool MosquitoRegistry::fixTime(MosquitoesInSeq* in)
      }
     }
    }
+  }
   return true;
  }
  else
@@ -1629,12 +2086,12 @@ bool MosquitoRegistry::fixTime(MosquitoesInSeq* in)
 }
 
 
-int MosquitoRegistry::markMosquitoesToKeep()
+int MosquitoRegistry::markMosquitoesToKeep(MosquitoesInSeq* in)
 {
  for(unsigned int i=0; i<Registry.size(); i++)
   for(unsigned int j=0; j<Registry[i].size(); j++)
  {
-  MosquitoPosition* mp=Registry[i][j].getMosquitoPointer();
+  MosquitoPosition* mp=positionOfPoint(in,trackID(i),j);
   if(mp)
   {
    mp->setFlag(MosquitoPosition::flagType::KEEPME);
@@ -1643,9 +2100,10 @@ int MosquitoRegistry::markMosquitoesToKeep()
  return 0;
 }
 
-bool MosquitoRegistry::estimateNextPosition(int i,double &ox, double &oy, unsigned long &on, double scalefactor /*=1.0*/)
+bool MosquitoRegistry::estimateNextPosition(int ID,double &ox, double &oy, unsigned long &on, double scalefactor /*=1.0*/)
 {
- if(i>0 && i<Registry.size())
+ long i=trackSlot(ID);
+ if(i>=0)
  {
   if(Registry[i].size()==2)
   {
@@ -1701,9 +2159,10 @@ bool MosquitoRegistry::estimateNextPosition(int i,double &ox, double &oy, unsign
   false;
 }
 
-bool MosquitoRegistry::estimatePrevPosition(int i,double &ox, double &oy, unsigned long &on, double scalefactor /*=1.0*/)
+bool MosquitoRegistry::estimatePrevPosition(int ID,double &ox, double &oy, unsigned long &on, double scalefactor /*=1.0*/)
 {
- if(i>0 && i<Registry.size())
+ long i=trackSlot(ID);
+ if(i>=0)
  {
   if(Registry[i].size()==2)
   {
@@ -1742,10 +2201,11 @@ bool MosquitoRegistry::estimatePrevPosition(int i,double &ox, double &oy, unsign
   false;
 }
 
-vector<vector<TrackPoint> > MosquitoRegistry::getMissingPieces(int n)
+vector<vector<TrackPoint> > MosquitoRegistry::getMissingPieces(int ID)
 {
  vector<vector<TrackPoint> > tmp;
- if(n<Registry.size() && n>=0)
+ long n=trackSlot(ID);
+ if(n>=0)
  {
   for(int m=0; m<Registry[n].size()-1; m++)
   {
@@ -1764,6 +2224,118 @@ vector<vector<TrackPoint> > MosquitoRegistry::getMissingPieces(int n)
 bool MosquitoRegistry::copyTo(MosquitoRegistry& a)
 {
     a.Registry=Registry;
+    a.Summary=Summary;
+    a.nextColor=nextColor;
+    a.Generation=Generation;
+    a.FreeSlots=FreeSlots;
+    a.FreeHead=FreeHead;
+    a.Order=Order;
+    a.OrderPos=OrderPos;
+    a.liveTracks=liveTracks;
+    a.sharedTracks=sharedTracks;
+    a.sharedChunks=sharedChunks;
+    a.sharedOrder=sharedOrder;
+    a.sharedFree=sharedFree;
+    a.invalidateFrameIndex();
+    a.invalidatePickIndex();
+    return true;
+}
+
+static void shareChunks(const vector<unsigned long> &v, vector<shared_ptr<const vector<unsigned long> > > &shared)
+{
+    // the chunks from the first dropped one on are copied again
+    for(unsigned long k=shared.size(); k*TRACKSNAPSHOTCHUNK<v.size(); k++)
+     shared.push_back(shared_ptr<const vector<unsigned long> >(new vector<unsigned long>(
+                      v.begin()+k*TRACKSNAPSHOTCHUNK, v.begin()+min(v.size(),(k+1)*TRACKSNAPSHOTCHUNK))));
+}
+
+static void restoreChunks(vector<unsigned long> &v, vector<shared_ptr<const vector<unsigned long> > > &shared,
+                          const vector<shared_ptr<const vector<unsigned long> > > &from)
+{
+    unsigned long n=0;
+    for(unsigned long k=0; k<from.size(); k++)
+     n+=from[k]->size();
+    v.resize(n);
+    for(unsigned long k=0; k<from.size(); k++)
+     if(k>=shared.size() || shared[k]!=from[k])
+      copy(from[k]->begin(), from[k]->end(), v.begin()+k*TRACKSNAPSHOTCHUNK);
+    shared=from;
+}
+
+registrySnapshot MosquitoRegistry::snapshot()
+{
+    // only chunks of slots changed since the last snapshot are built again,
+    // and within them only the changed tracks are copied
+    registrySnapshot s;
+    unsigned long nT=Registry.size();
+    unsigned long nC=(nT+TRACKSNAPSHOTCHUNK-1)/TRACKSNAPSHOTCHUNK;
+    sharedTracks.resize(nT);
+    sharedChunks.resize(nC);
+    for(unsigned long k=0; k<nC; k++)
+     if(!sharedChunks[k])
+     {
+      registryChunk* c=new registryChunk;
+      for(unsigned long i=k*TRACKSNAPSHOTCHUNK; i<min(nT,(k+1)*TRACKSNAPSHOTCHUNK); i++)
+      {
+       if(!sharedTracks[i])
+        sharedTracks[i]=shared_ptr<const vector<TrackPoint> >(new vector<TrackPoint>(Registry[i]));
+       c->tracks.push_back(sharedTracks[i]);
+       c->colors.push_back(Summary[i].color);
+       c->Generation.push_back(Generation[i]);
+       c->OrderPos.push_back(OrderPos[i]);
+      }
+      sharedChunks[k]=shared_ptr<const registryChunk>(c);
+     }
+    shareChunks(Order, sharedOrder);
+    shareChunks(FreeSlots, sharedFree);
+    s.slots=sharedChunks;
+    s.Order=sharedOrder;
+    s.FreeSlots=sharedFree;
+    s.FreeHead=FreeHead;
+    s.nextColor=nextColor;
+    s.liveTracks=liveTracks;
+    return s;
+}
+
+bool MosquitoRegistry::restore(const registrySnapshot& s)
+{
+    // chunks and tracks still shared with the snapshot are unchanged
+    unsigned long nT=0;
+    for(unsigned long k=0; k<s.slots.size(); k++)
+     nT+=s.slots[k]->tracks.size();
+    Registry.resize(nT);
+    Summary.resize(nT);
+    Generation.resize(nT);
+    OrderPos.resize(nT);
+    sharedTracks.resize(nT);
+    for(unsigned long k=0; k<s.slots.size(); k++)
+    {
+     if(k<sharedChunks.size() && sharedChunks[k]==s.slots[k])
+      continue;
+     const registryChunk &c=*s.slots[k];
+     for(unsigned long j=0; j<c.tracks.size(); j++)
+     {
+      unsigned long i=k*TRACKSNAPSHOTCHUNK+j;
+      if(sharedTracks[i]!=c.tracks[j])
+      {
+       Registry[i]=*c.tracks[j];
+       vector<vector<double> >().swap(Summary[i].statistics);
+       sharedTracks[i]=c.tracks[j];
+      }
+      Summary[i].valid=false;
+      Summary[i].color=c.colors[j];
+      Generation[i]=c.Generation[j];
+      OrderPos[i]=c.OrderPos[j];
+     }
+    }
+    sharedChunks=s.slots;
+    restoreChunks(Order, sharedOrder, s.Order);
+    restoreChunks(FreeSlots, sharedFree, s.FreeSlots);
+    FreeHead=s.FreeHead;
+    nextColor=s.nextColor;
+    liveTracks=s.liveTracks;
+    invalidateFrameIndex();
+    invalidatePickIndex();
     return true;
 }
 
@@ -1772,17 +2344,21 @@ vector<vector<cv::Scalar> > MosquitoRegistry::getTrackMetaForAni(unsigned long f
     // 0 fixed color
     // 1 color track by first occurence
     // 2 color by track ID(rainbow)
-    // 3 color by track ID(random)
+    // 3 color by track (random, fixed per track)
     // 4 rainbow tail...
     // 5 color by time
     vector<vector<cv::Scalar> > tmp;
-    srand (static_cast <unsigned> (time(0)));
-    for(unsigned long i=0; i<Registry.size();i++)
+    int fromFrame=(int)frame-(int)lastn+1;
+    vector<unsigned long> ids=tracksInFrameRange(fromFrame,(int)frame,mint);
+    for(unsigned long k=0; k<ids.size();k++)
     {
+        unsigned long i=ids[k];
+        unsigned long jb,je;
+        pointsInFrameRange(i,fromFrame,(int)frame,jb,je);
         int displayTrack=0;
         int firstPoint=-1;
         int lastPoint=-1;
-        for(unsigned long j=0; j<Registry[i].size(); j++)
+        for(unsigned long j=jb; j<je; j++)
         if(Registry[i][j].frame>(int)frame-(int)lastn && Registry[i][j].frame<=frame)
         {
            if(firstPoint==-1) firstPoint=j;
@@ -1811,11 +2387,11 @@ vector<vector<cv::Scalar> > MosquitoRegistry::getTrackMetaForAni(unsigned long f
          }
          else if(colorByFlag==3)
          {
-          cv::Scalar color=getRandomColor(i);
+          cv::Scalar color=getColor(Summary[i].color,0.,1.);
           for(unsigned long j=0; j<displayTrack; j++)
            tmp2.push_back(color);
          }
-         else if(colorByFlag==4)
+         else if(colorByFlag==4 && displayTrack>0)
          {
           for(unsigned long j=firstPoint; j<=lastPoint; j++)
           {
@@ -1823,7 +2399,7 @@ vector<vector<cv::Scalar> > MosquitoRegistry::getTrackMetaForAni(unsigned long f
            tmp2.push_back(color);
           }
          }
-         else if(colorByFlag==5)
+         else if(colorByFlag==5 && displayTrack>0)
          {
           for(unsigned long j=firstPoint; j<lastPoint; j++)
           {
@@ -1995,9 +2571,11 @@ vector<vector<double> > MosquitoRegistry::trackStatistics(vector<TrackPoint> cT)
  return a; 
 }
 
-bool MosquitoRegistry::joinBasedOnStatistics(int n, int m)
+bool MosquitoRegistry::joinBasedOnStatistics(int nID, int mID)
 {
- if(n<0 || n>Registry.size() || m<0 || m>Registry.size())
+ long n=trackSlot(nID);
+ long m=trackSlot(mID);
+ if(n<0 || m<0 || Registry[n].size()<2 || Registry[m].size()<2)
   return false;
  double conns=-1;
  double connvx=-1;
@@ -2024,8 +2602,8 @@ bool MosquitoRegistry::joinBasedOnStatistics(int n, int m)
   cerr<<"Tracks du intersect...\n";
   return false;
  }
- vector<vector<double> > aN=trackStatistics(getVectorOfTrackPoints(n));
- vector<vector<double> > aM=trackStatistics(getVectorOfTrackPoints(m));
+ vector<vector<double> > aN=trackStatistics(nID);
+ vector<vector<double> > aM=trackStatistics(mID);
  double allowDifferenceOf=0.1;
  double allowRotationOf=45./180.*CV_PI;
  if(aN.size()==0 || aM.size()==0)
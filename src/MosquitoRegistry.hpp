@@ -23,6 +23,8 @@
 #include "MosquitoesInFrame.hpp"
 #include "MosquitoPosition.hpp"
 #include <vector>
+#include <memory>
+#include <unordered_map>
 //opencv
 #if CV_MAJOR_VERSION < 3
 #include "opencv2/core/core.hpp"
@@ -44,8 +46,62 @@
 
 using namespace std;
 
+/**
+  * \brief Candidate connection between the end of one track and another track
+  */
+struct trackConnection {
+    double cost;
+    unsigned long source;
+    unsigned long target;
+};
+
+/**
+  * \brief Cached per track data of the registry, recalculated when the track changes
+  */
+struct trackSummary {
+    bool valid;
+    int firstFrame;
+    int lastFrame;
+    double length;
+    double duration;
+    double meanSpeed;
+    double maxSpeed;
+    double minX;
+    double maxX;
+    double minY;
+    double maxY;
+    double color;
+    vector<vector<double> > statistics;
+};
+
+/**
+  * \brief Consecutive track slots of a registrySnapshot, unchanged tracks are shared between chunks
+  */
+struct registryChunk {
+    vector<shared_ptr<const vector<TrackPoint> > > tracks;
+    vector<double> colors;
+    vector<unsigned int> Generation;
+    vector<long> OrderPos;
+};
+
+/**
+  * \brief Undo point of a MosquitoRegistry, chunks which did not change are shared between snapshots
+  */
+struct registrySnapshot {
+    vector<shared_ptr<const registryChunk> > slots;
+    vector<shared_ptr<const vector<unsigned long> > > Order;
+    vector<shared_ptr<const vector<unsigned long> > > FreeSlots;
+    unsigned long FreeHead;
+    unsigned long nextColor;
+    unsigned long liveTracks;
+};
+
 /**
   * \brief Book keeping class for the tracking algorithm 
+  *
+  * Tracks are kept in slots which are reused after a track is deleted, the track IDs
+  * handed out combine the slot with a generation counter, so IDs of other tracks stay
+  * valid when a track is deleted and IDs of deleted tracks are rejected.
   */
 class MosquitoRegistry
 {
@@ -70,38 +126,99 @@ public:
     vector<TrackPoint> getVectorOfTrackPoints(int ID);
     int addVectorOfTrackPoints(vector<TrackPoint> t, int ofx, int ofy);
     int numOfTracks();
+    vector<int> trackIDs();
     vector<vector<TrackPoint> > getRegistry();
     vector<int> findTrackID(double xi, double yi, double minDist, int fromFrame, int toFrame);
     vector<cv::Point2f> getSingleTrack(int ID);
-    bool removePointFromTrack(int n, int m, bool split_here = false);
-    bool addPointToTrack(int n, TrackPoint a, bool replace = false);
-    bool sortTrack(int n);
-    bool deleteTrack(int n);
-    bool joinTracks(int n,int m);
-    bool splitTrack(int n,int m);
-    bool addVectorOfTrackPointsToTrack(int n, vector<TrackPoint> t, int ofx = 0, int ofy = 0);
+    bool removePointFromTrack(int ID, int m, bool split_here = false);
+    bool addPointToTrack(int ID, TrackPoint a, bool replace = false);
+    bool sortTrack(int ID);
+    bool deleteTrack(int ID);
+    bool joinTracks(int nID,int mID);
+    bool splitTrack(int ID,int m);
+    bool addVectorOfTrackPointsToTrack(int ID, vector<TrackPoint> t, int ofx = 0, int ofy = 0);
     bool autoJoinTracks(double maxDist, unsigned long maxTempDist, int remTooShort = 3, double angle = 0.5);
     double trackLength(vector<TrackPoint> t);
     double calcDistFromLine(vector<TrackPoint> t);
     vector<TrackPoint> removeSpikes(vector<TrackPoint> t, double angle = 0.5);
     int removeTooShort(int x);
-    vector<double> lineLineDistance(unsigned int n, unsigned int m);
-    bool updateMosquitoPointer(MosquitoesInSeq* in);
+    bool linkPositions(MosquitoesInSeq* in);
+    MosquitoPosition* positionOfPoint(MosquitoesInSeq* in, int ID, unsigned long m);
     bool connectRestingTracks(int maxDT, double maxDX);
-    vector<vector<double> > getDataForTrack(unsigned long n, int dataType);
+    vector<vector<double> > getDataForTrack(unsigned long ID, int dataType);
     bool fixTime(MosquitoesInSeq* in);
-    int markMosquitoesToKeep();
-    bool estimateNextPosition(int i,double &ox, double &oy, unsigned long &on, double scalefactor = 1.0);
-    bool estimatePrevPosition(int i,double &ox, double &oy, unsigned long &on, double scalefactor = 1.0);
-    vector<vector<TrackPoint> > getMissingPieces(int n);
+    int markMosquitoesToKeep(MosquitoesInSeq* in);
+    bool estimateNextPosition(int ID,double &ox, double &oy, unsigned long &on, double scalefactor = 1.0);
+    bool estimatePrevPosition(int ID,double &ox, double &oy, unsigned long &on, double scalefactor = 1.0);
+    vector<vector<TrackPoint> > getMissingPieces(int ID);
     bool copyTo(MosquitoRegistry& a);
+    registrySnapshot snapshot();
+    bool restore(const registrySnapshot& s);
     vector<vector<cv::Scalar> > getTrackMetaForAni(unsigned long frame,int lastn, int mint, int colorByFlag, double startFrame, double endFrame);
     cv::Scalar getRandomColor(int i);
     cv::Scalar getColor(double i, double from, double to);
     vector<vector<double> > trackStatistics(vector<TrackPoint> cT);
-    bool joinBasedOnStatistics(int n, int m);
+    vector<vector<double> > trackStatistics(int ID);
+    trackSummary getTrackSummary(int ID);
+    bool joinBasedOnStatistics(int nID, int mID);
     
 private:
+    long trackSlot(int ID);
+    int trackID(unsigned long slot);
+    long newTrackSlot();
+    bool trackSlotAvailable();
+    void compactTrackOrder();
+    vector<double> lineLineDistance(unsigned int n, unsigned int m);
+    bool mergeTracks(int n,int m);
+    void findTrackSuccessors(unsigned long i, unsigned long k, const vector<pair<int,unsigned long> > &starts, double maxDist, unsigned long maxTempDist, vector<trackConnection> &c);
+    int joinConnectedTracks(vector<trackConnection> c, bool oneToOne);
+    void invalidateTrack(unsigned long ID);
+    void updateTrackSummary(unsigned long ID);
+    trackSummary newTrackSummary();
+    void eraseTrack(unsigned long ID);
+    void invalidateFrameIndex();
+    void updateFrameIndex();
+    void addToFrameIndex(unsigned long ID);
+    vector<unsigned long> tracksInFrameRange(int fromFrame, int toFrame, int mint);
+    void pointsInFrameRange(unsigned long ID, int fromFrame, int toFrame, unsigned long &jb, unsigned long &je);
+    void invalidatePickIndex();
+    void updatePickIndex();
+    void markTrackChanged(unsigned long ID);
+    void markOrderChanged(vector<shared_ptr<const vector<unsigned long> > > &shared, unsigned long i);
+    void clearShared();
+    void removeFromPickIndex(unsigned long ID);
+    void addToPickIndex(unsigned long ID);
     vector<vector<TrackPoint> > Registry;
+    // one entry per track, the colour is kept when the other values are invalidated
+    vector<trackSummary> Summary;
+    unsigned long nextColor;
+    // slot map: generation per slot, free slots for reuse and the iteration order of
+    // the live slots (OrderPos is -1 for free slots, Order is compacted lazily);
+    // FreeSlots is a queue, the slots before FreeHead were already reused
+    vector<unsigned int> Generation;
+    vector<unsigned long> FreeSlots;
+    unsigned long FreeHead;
+    vector<unsigned long> Order;
+    vector<long> OrderPos;
+    unsigned long liveTracks;
+    // copies of the tracks and chunks shared with the snapshots, an empty pointer
+    // marks a track or chunk changed since the last snapshot; Order and FreeSlots
+    // only change at their end, so only their chunks from there on are dropped
+    vector<shared_ptr<const vector<TrackPoint> > > sharedTracks;
+    vector<shared_ptr<const registryChunk> > sharedChunks;
+    vector<shared_ptr<const vector<unsigned long> > > sharedOrder;
+    vector<shared_ptr<const vector<unsigned long> > > sharedFree;
+    // frame interval index for the per frame track queries, rebuilt lazily after edits
+    bool frameIndexValid;
+    vector<int> trackFirstFrame;
+    vector<int> trackLastFrame;
+    vector<bool> trackIsSorted;
+    vector<vector<unsigned long> > frameBlocks;
+    // spatial index of all points per frame block for picking tracks, edited
+    // tracks are re-indexed on the next query, bulk changes rebuild it
+    bool pickIndexValid;
+    vector<vector<long long> > pickCellsOfTrack;
+    unordered_map<long long, vector<pair<unsigned long,unsigned long> > > pickCells;
+    vector<unsigned long> pickDirty;
 };
 #endif //MOSQUITOREGISTRY_hpp
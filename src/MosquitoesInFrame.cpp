@@ -18,11 +18,13 @@
  */
 #include "MosquitoPosition.hpp"
 #include "MosquitoesInFrame.hpp"
+#include "BinaryIO.hpp"
 #include <vector>
 #include <iostream>
 #include <iomanip> 
 #include <algorithm>
 #include <cmath>
+#include <unordered_set>
 #include <QPointF>
 //opencv
 #if CV_MAJOR_VERSION < 3
@@ -57,6 +59,10 @@ MosquitoesInFrame::MosquitoesInFrame()
     tsSec=0;
     tsMSec=0;
     tsUSec=0;
+    nextSlot=0;
+    journal=nullptr;
+    journalFrame=0;
+    counts=nullptr;
 }
 
 MosquitoesInFrame::MosquitoesInFrame(const MosquitoesInFrame& a)
@@ -73,19 +79,47 @@ MosquitoesInFrame::MosquitoesInFrame(const MosquitoesInFrame& a)
     tsSec=a.tsSec;
     tsMSec=a.tsMSec;
     tsUSec=a.tsUSec;
+    nextSlot=a.nextSlot;
+    journal=nullptr;
+    journalFrame=0;
+    counts=nullptr;
+}
+
+MosquitoesInFrame& MosquitoesInFrame::operator=(const MosquitoesInFrame& a)
+{
+    // the frame stays attached to its own journal and counts
+    processed=a.processed;
+    maxDiff=a.maxDiff;
+    frameNo=a.frameNo;
+    ith=a.ith;
+    minTh=a.minTh;
+    th=a.th;
+    minA=a.minA;
+    maxA=a.maxA;
+    countChanged((long)a.mpos.size()-(long)mpos.size());
+    mpos=a.mpos;
+    tsSec=a.tsSec;
+    tsMSec=a.tsMSec;
+    tsUSec=a.tsUSec;
+    nextSlot=a.nextSlot;
+    return *this;
 }
 
 int MosquitoesInFrame::addMosquito(MosquitoPosition impos,int ofx, int ofy)
 {
     impos.move(ofx,ofy);
+    impos.setSlot(newSlot());
     mpos.push_back(impos);
+    journalAdded(impos);
     return 0;
 }
 
 int MosquitoesInFrame::addMosquito(double ix, double iy, double iarea, double imaxInt, double circularity, double inertia, double convexity, double radius, vector<cv::Point> c /* =vector<cv::Point>() */)
 {
     MosquitoPosition tmp(ix, iy, iarea, imaxInt, circularity, inertia, convexity, radius,c);
+    tmp.setSlot(newSlot());
     mpos.push_back(tmp);
+    journalAdded(tmp);
     if(iarea==-1 && imaxInt==-1)
        cout << "Adding point at : " << ix<<" "<<iy<<endl;    
     return 0;
@@ -94,7 +128,9 @@ int MosquitoesInFrame::addMosquito(double ix, double iy, double iarea, double im
 int MosquitoesInFrame::addMosquito(double ix, double iy, double iarea, double imaxInt)
 {
     MosquitoPosition tmp(ix, iy, iarea, imaxInt, 0, 0, 0, 0);
+    tmp.setSlot(newSlot());
     mpos.push_back(tmp);
+    journalAdded(tmp);
     if(iarea==-1 && imaxInt==-1)
        cout << "Adding point at : " << ix<<" "<<iy<<endl;    
     return 0;
@@ -148,6 +184,8 @@ int MosquitoesInFrame::removeMosquito(double ix, double iy, int searchRadius /*=
 
 int MosquitoesInFrame::removeAllMosquito()
 {
+    for(unsigned long i=0; i<mpos.size(); i++)
+     journalRemoved(mpos[i]);
     vector<MosquitoPosition>().swap(mpos);
     return 0;
 }
@@ -181,6 +219,15 @@ MosquitoPosition* MosquitoesInFrame::mosqi(double ix, double iy, double searchRa
     return tmp;
 }
 
+MosquitoPosition* MosquitoesInFrame::mosqBySlot(unsigned int s)
+{
+    auto it=lower_bound(mpos.begin(), mpos.end(), s,
+                [](MosquitoPosition& a, unsigned int b){return a.getSlot()<b;});
+    if(it!=mpos.end() && it->getSlot()==s)
+     return &(*it);
+    return nullptr;
+}
+
 int MosquitoesInFrame::mosqIndex(double ix, double iy)
 {
     int n=-1;
@@ -234,6 +281,8 @@ int MosquitoesInFrame::clear()
     th=0;
     minA=0;
     maxA=0;
+    for(unsigned long i=0; i<mpos.size(); i++)
+     journalRemoved(mpos[i]);
     mpos.clear();
     return 0;
 }
@@ -267,12 +316,23 @@ for(int j=0; j<cluster.size();j++)
 }
 sort( markForDeletion.begin(), markForDeletion.end() );
 markForDeletion.erase( unique( markForDeletion.begin(), markForDeletion.end() ), markForDeletion.end() );
-for(int i=markForDeletion.size()-1; i>=0; i--)
+// compact in place, keeping the order of the remaining positions
+unsigned long k=0, d=0;
+for(unsigned long i=0; i<mpos.size(); i++)
 {
-  mpos[markForDeletion[i]] = mpos.back();
-  mpos.pop_back();
-  removed++;
+  if(d<markForDeletion.size() && markForDeletion[d]==i)
+  {
+   journalRemoved(mpos[i]);
+   d++;
+   removed++;
+  }
+  else
+  {
+   if(k!=i) mpos[k]=mpos[i];
+   k++;
+  }
 }
+mpos.erase(mpos.begin()+k, mpos.end());
 }
 return removed;
 }
@@ -281,9 +341,12 @@ int MosquitoesInFrame::clean(double minArea,double maxArea)
 {
 int removed=mpos.size();
 mpos.erase(std::remove_if(mpos.begin(), mpos.end(), 
-                [&minArea,&maxArea](MosquitoPosition& x){
+                [this,&minArea,&maxArea](MosquitoPosition& x){
                     if (x.getA()<minArea || x.getA()>maxArea)
+                    {
+                        journalRemoved(x);
                         return true;
+                    }
                     else
                         return false;
                 }), mpos.end());
@@ -292,44 +355,6 @@ return removed;
 }
 
 
-int MosquitoesInFrame::appendToBackup(ostream* o)
-{
-        if(o->bad())
-        {
-            cerr << "Error backup file not opened!"<<endl;
-        }
-        else
-        {
-            MosquitoPosition* currentMosquito;
-            for(int j=0; j<numOfMosquitoes(); j++)
-            {
-                currentMosquito=mosqi(j);
-                int flag=currentMosquito->getFlag();
-                *o<<std::setprecision(16) <<std::fixed
-                  <<currentMosquito->getX()<<'\t'
-                  <<currentMosquito->getY()<<'\t'
-                  <<currentMosquito->getI()<<'\t'
-                  <<currentMosquito->getA()<<'\t'
-                  <<getMaxDiff()<<'\t'
-                  <<static_cast<double>(getF())<<'\t'
-                  <<static_cast<double>(getTsSec())<<'\t'
-                  <<static_cast<double>(getTsMSec())<<'\t'
-                  <<static_cast<double>(getTsUSec())<<'\t'
-                  <<static_cast<double>(flag)<<'\n';
-                 if(currentMosquito->MosquitoHasContour())
-                 {
-                  vector<cv::Point> c=currentMosquito->getContour();
-                  *o<<"#contour "<<c.size();
-                  for(int cc=0; cc<c.size(); cc++)
-                   *o<<" "<<c[cc].x<<" "<<c[cc].y;
-                  *o<<"\n";
-                 }
-            }
-            o->flush();
-        }
-    return 0;
-}
-
 int MosquitoesInFrame::removePointsInsideOfPolygon(vector<QPointF> poly, bool inverse /* = false */)
 {
     int num=0;
@@ -431,6 +456,7 @@ bool MosquitoesInFrame::removeAndClean(int i)
 {
     if(i<mpos.size())
     {
+        journalRemoved(mpos[i]);
         mpos.erase(mpos.begin()+i);
         return true;
     }
@@ -732,3 +758,71 @@ void MosquitoesInFrame::setKeepMeFlag(bool b)
  for(int i=0; i<mpos.size(); i++) mpos[i].setFlag(MosquitoPosition::flagType::KEEPME,b);
 }
 
+
+void MosquitoesInFrame::removeBySlot(const vector<MosquitoPosition>& p)
+{
+ if(p.size()==0) return;
+ long n=mpos.size();
+ unordered_set<unsigned int> slots;
+ for(unsigned long i=0; i<p.size(); i++) slots.insert(p[i].getSlot());
+ mpos.erase(std::remove_if(mpos.begin(), mpos.end(),
+                [&slots](MosquitoPosition& x){
+                    return slots.count(x.getSlot())>0;
+                }), mpos.end());
+ countChanged((long)mpos.size()-n);
+}
+
+void MosquitoesInFrame::insertBySlot(const vector<MosquitoPosition>& p)
+{
+ if(p.size()==0) return;
+ // slots grow with the order of insertion, so merging by slot restores the order
+ vector<MosquitoPosition> tmp(p);
+ std::sort(tmp.begin(), tmp.end(),
+                [](const MosquitoPosition& a, const MosquitoPosition& b){
+                    return a.getSlot()<b.getSlot();
+                });
+ vector<MosquitoPosition> merged;
+ merged.reserve(mpos.size()+tmp.size());
+ unsigned long i=0;
+ unsigned long j=0;
+ while(i<mpos.size() || j<tmp.size())
+ {
+  if(j>=tmp.size() || (i<mpos.size() && mpos[i].getSlot()<tmp[j].getSlot()))
+   merged.push_back(mpos[i++]);
+  else
+   merged.push_back(tmp[j++]);
+ }
+ mpos.swap(merged);
+ countChanged(tmp.size());
+ if(tmp.back().getSlot()>=nextSlot) nextSlot=tmp.back().getSlot()+1;
+}
+
+void MosquitoesInFrame::positionsToBinary(vector<char>& b)
+{
+ putBinary<uint32_t>(b, mpos.size());
+ for(unsigned long i=0; i<mpos.size(); i++)
+  mpos[i].toBinary(b);
+}
+
+bool MosquitoesInFrame::positionsFromBinary(const char*& p, const char* end)
+{
+ // replaces the positions without reporting them to the journal
+ uint32_t n;
+ if(!getBinary(p,end,n))
+  return false;
+ vector<MosquitoPosition> tmp;
+ tmp.reserve(n);
+ for(uint32_t i=0; i<n; i++)
+  if(!MosquitoPosition::fromBinary(p,end,tmp))
+   return false;
+ mpos.swap(tmp);
+ return true;
+}
+
+unsigned long MosquitoesInFrame::positionMemory()
+{
+ unsigned long m=(mpos.capacity()-mpos.size())*sizeof(MosquitoPosition);
+ for(unsigned long i=0; i<mpos.size(); i++)
+  m+=mpos[i].memoryUsage();
+ return m;
+}
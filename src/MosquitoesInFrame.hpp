@@ -19,6 +19,8 @@
 #ifndef MOSQUITOESINFRAME_hpp
 #define MOSQUITOESINFRAME_hpp
 #include "MosquitoPosition.hpp"
+#include "PositionJournal.hpp"
+#include "DetectionCounts.hpp"
 #include <vector>
 #include <iostream>
 #include <iomanip> 
@@ -53,6 +55,7 @@ public:
     MosquitoesInFrame();
     MosquitoesInFrame(const MosquitoesInFrame& a);
     ~MosquitoesInFrame() {};
+    MosquitoesInFrame& operator=(const MosquitoesInFrame& a);
     int addMosquito(MosquitoPosition impos,int ofx, int ofy);
     int addMosquito(double ix, double iy, double iarea, double imaxInt, double circularity, double inertia, double convexity, double radius, vector<cv::Point> c = vector<cv::Point>());
     int addMosquito(double ix, double iy, double iarea, double imaxInt);
@@ -69,6 +72,7 @@ public:
     int numOfMosquitoes();
     MosquitoPosition* mosqi(unsigned long i);
     MosquitoPosition* mosqi(double ix, double iy,double searchRadius=3);
+    MosquitoPosition* mosqBySlot(unsigned int s);
     int mosqIndex(double ix, double iy);
     bool getNearest(double ix, double iy, double searchRadius,int &j, double &odist);
     int setMinArea(double v)
@@ -175,7 +179,6 @@ public:
 
     int clear();
 
-    int appendToBackup(ostream* o);
     bool PointInPolygon(MosquitoPosition m, vector<QPointF>  poly);
     int removePointsInsideOfPolygon(vector<QPointF> poly, bool inverse = false);
     vector<cv::Point2f> pointsInsideOfPolygon(vector<QPointF> poly);
@@ -190,9 +193,33 @@ public:
     int filterByInertia(double I, bool invert = false);
     int filterByConvexity(double I, bool invert = false);
     void setKeepMeFlag(bool b);
+    void setJournal(PositionJournal* j, unsigned long frame, DetectionCounts* c = nullptr)
+    {
+        journal=j;
+        journalFrame=frame;
+        counts=c;
+    };
+    void removeBySlot(const vector<MosquitoPosition>& p);
+    void insertBySlot(const vector<MosquitoPosition>& p);
+    void positionsToBinary(vector<char>& b);
+    bool positionsFromBinary(const char*& p, const char* end);
+    void dropPositions(){vector<MosquitoPosition>().swap(mpos);};
+    unsigned long positionMemory();
 
 private:
+    unsigned int newSlot(){return nextSlot++;};
+    void journalAdded(const MosquitoPosition& p){if(journal) journal->recordAdded(journalFrame,p); countChanged(1);};
+    void journalRemoved(const MosquitoPosition& p){if(journal) journal->recordRemoved(journalFrame,p); countChanged(-1);};
+    void countChanged(long delta){if(counts) counts->add(journalFrame,delta);};
+    // positions are only appended and removals keep the order, so slots in
+    // mpos are always ascending
     vector<MosquitoPosition> mpos;
+    unsigned int nextSlot;
+    // journal of the owning MosquitoesInSeq, copies of a frame are not journaled
+    PositionJournal* journal;
+    unsigned long journalFrame;
+    // detection counts of the owning MosquitoesInSeq, also indexed by journalFrame
+    DetectionCounts* counts;
     double maxDiff;
     unsigned long frameNo;
     int processed;
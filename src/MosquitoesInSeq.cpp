@@ -19,6 +19,7 @@
 #include "MosquitoesInSeq.hpp"
 #include "MosquitoesInFrame.hpp"
 #include "MosquitoPosition.hpp"
+#include "PositionBackup.hpp"
 #include <vector>
 //opencv
 #if CV_MAJOR_VERSION < 3
@@ -70,6 +71,7 @@ MosquitoesInSeq::MosquitoesInSeq()
 
 MosquitoesInSeq::MosquitoesInSeq(MosquitoesInSeq&& other)
 {
+    other.pager.loadAll(other.mframes);
     mframes=other.mframes;
     nFrames=other.nFrames;
     haveSeq=other.haveSeq;
@@ -85,6 +87,12 @@ MosquitoesInSeq::MosquitoesInSeq(MosquitoesInSeq&& other)
     dynamic=other.dynamic;
     triggerBased=other.triggerBased;
     FrameLookup=other.FrameLookup;
+    journal=other.journal;
+    pager=other.pager;
+    counts=other.counts;
+    if(counts.size()!=mframes.size())
+     counts.reset(mframes.size());
+    attachJournal();
 }
 MosquitoesInSeq::~MosquitoesInSeq()
 {
@@ -93,21 +101,29 @@ MosquitoesInSeq& MosquitoesInSeq::operator=(MosquitoesInSeq&& other)
 {
     if(this!=&other)
     {
+    other.pager.loadAll(other.mframes);
     mframes=other.mframes;
     nFrames=other.nFrames;
     initialized=other.initialized;
     haveSeq=other.haveSeq;
     currSeq=other.currSeq;
+    journal=other.journal;
+    pager=other.pager;
+    counts=other.counts;
     if(other.initialized)
     {
      vector<MosquitoesInFrame>().swap(other.mframes);  
      other.nFrames=0;
      other.initialized=0;
+     other.journal.clear();
+     other.pager.reset();
+     other.counts.reset(0);
     }
     }
     dynamic=other.dynamic;
     triggerBased=other.triggerBased;
     FrameLookup=other.FrameLookup;
+    attachJournal();
     return *this;
 }
 
@@ -115,6 +131,9 @@ MosquitoesInSeq& MosquitoesInSeq::operator=(MosquitoesInSeq& other)
 {
     initialized=other.initialized;
     nFrames=other.nFrames;
+    other.pager.loadAll(other.mframes);
+    pager=other.pager;
+    counts=other.counts;
     if(initialized)
     {
     vector<MosquitoesInFrame>().swap(mframes);  
@@ -126,6 +145,8 @@ MosquitoesInSeq& MosquitoesInSeq::operator=(MosquitoesInSeq& other)
     dynamic=other.dynamic;
     triggerBased=other.triggerBased;
     FrameLookup=other.FrameLookup;
+    journal=other.journal;
+    attachJournal();
     return *this;
 }
 
@@ -135,6 +156,10 @@ MosquitoesInSeq::MosquitoesInSeq(const MosquitoesInSeq& a)
     nFrames=a.nFrames;
     haveSeq=a.haveSeq;
     currSeq=a.currSeq;
+    // paged out positions have to be copied as well, paging them in does not change a
+    const_cast<MosquitoesInSeq&>(a).pager.loadAll(const_cast<MosquitoesInSeq&>(a).mframes);
+    pager=a.pager;
+    counts=a.counts;
 
     vector<MosquitoesInFrame>().swap(mframes);  
     
@@ -143,6 +168,8 @@ MosquitoesInSeq::MosquitoesInSeq(const MosquitoesInSeq& a)
     dynamic=a.dynamic;
     triggerBased=a.triggerBased;
     FrameLookup=a.FrameLookup;
+    journal=a.journal;
+    attachJournal();
 }
 
 int MosquitoesInSeq::setNoOfFrames(unsigned long frames)
@@ -170,6 +197,10 @@ int MosquitoesInSeq::setNoOfFrames(unsigned long frames)
         }
 
     }
+    journal.clear();
+    pager.reset();
+    counts.reset(mframes.size());
+    attachJournal();
     return 0;
 }
 
@@ -187,7 +218,7 @@ MosquitoesInFrame* MosquitoesInSeq::mosqInFrameI(unsigned long i, bool directAcc
      }
      if(i<mframes.size())
      {
-      pointer=&mframes[i];
+      pointer=pagedFrame(i);
       return pointer;
      }
      else
@@ -204,20 +235,20 @@ MosquitoesInFrame* MosquitoesInSeq::mosqInFrameI(unsigned long i, bool directAcc
         {
          long wf=findTrigger(tmp);
          if(wf!=-1)
-          pointer=&mframes[wf];
+          pointer=pagedFrame(wf);
         }
      }     
      else
      {
      long wf=findTrigger(i);
      if(wf!=-1)
-        pointer=&mframes[wf];
+        pointer=pagedFrame(wf);
      }
     }
     else
     {
     if(i<nFrames)
-        pointer=&mframes[i];
+        pointer=pagedFrame(i);
     }
     return pointer;
 }
@@ -230,7 +261,7 @@ vector<cv::Point2f> MosquitoesInSeq::getAllPos(unsigned long i, bool isTrigger /
     {
     if(i<nFrames)
     {
-        currentFrame=&mframes[i];
+        currentFrame=&frameAt(i);
         MosquitoPosition* currentMosquito=nullptr;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -252,7 +283,7 @@ vector<cv::Point2f> MosquitoesInSeq::getAllPos(unsigned long i, bool isTrigger /
       long wfi=findTrigger(t);
       if(wfi!=-1)
       {
-        currentFrame=&mframes[wfi];
+        currentFrame=&frameAt(wfi);
         MosquitoPosition* currentMosquito=nullptr;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -277,7 +308,7 @@ vector<cv::Point2f> MosquitoesInSeq::getAllPos(unsigned long n, unsigned long m,
     {
     if(i<nFrames)
     {
-        currentFrame=&mframes[i];
+        currentFrame=&frameAt(i);
         MosquitoPosition* currentMosquito=nullptr;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -306,7 +337,7 @@ vector<cv::Point2f> MosquitoesInSeq::getAllPos(unsigned long n, unsigned long m,
        if(wfj==-1) wfj=wfi+1;
        for(unsigned long i=wfi; i<wfj;i++)
        {
-        currentFrame=&mframes[i];
+        currentFrame=&frameAt(i);
         MosquitoPosition* currentMosquito=nullptr;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -333,7 +364,7 @@ vector<double> MosquitoesInSeq::getPointMeta(unsigned long n, unsigned long m, b
     {
     if(i<nFrames)
     {
-        currentFrame=&mframes[i];
+        currentFrame=&frameAt(i);
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
            MosquitoPosition* currentMosquito=nullptr;
@@ -361,7 +392,7 @@ vector<double> MosquitoesInSeq::getPointMeta(unsigned long n, unsigned long m, b
        if(wfj==-1) wfj=wfi+1;
        for(unsigned long i=wfi; i<wfj;i++)
        {
-         currentFrame=&mframes[i];
+         currentFrame=&frameAt(i);
          for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
          {
            MosquitoPosition* currentMosquito=nullptr;
@@ -383,7 +414,7 @@ vector<double> MosquitoesInSeq::getPointMeta(unsigned long n, bool isTrigger /*=
     {
     if(n<nFrames)
     {
-        currentFrame=&mframes[n];
+        currentFrame=&frameAt(n);
         MosquitoPosition* currentMosquito;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -405,7 +436,7 @@ vector<double> MosquitoesInSeq::getPointMeta(unsigned long n, bool isTrigger /*=
       long wfi=findTrigger(t);
       if(wfi!=-1)
       {
-        currentFrame=&mframes[wfi];
+        currentFrame=&frameAt(wfi);
         MosquitoPosition* currentMosquito;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -421,10 +452,58 @@ vector<double> MosquitoesInSeq::getPointMeta(unsigned long n, bool isTrigger /*=
 
 int  MosquitoesInSeq::getNumOfAllPos()
 {
-    int tmp=0;
-    for(unsigned long i=0;i<mframes.size();i++)
+    return counts.total();
+}
+
+long MosquitoesInSeq::countInRange(unsigned long n, unsigned long m, bool isTrigger /*= false*/)
+{
+    // number of positions in the frames [n, m)
+    if(!dynamic)
+    {
+     if(m>nFrames)m=nFrames;
+     return counts.range(n,m);
+    }
+    long tmin=n;
+    long tmax=m;
+    if(!isTrigger)
     {
-        tmp += mframes[i].numOfMosquitoes();
+     tmin=getTriggerFromSeq(n);
+     tmax=getTriggerFromSeq(m);
+    }
+    if(tmin<=0 || tmax<=tmin)
+     return 0;
+    unsigned long wfi=lower_bound(FrameLookup.begin(),FrameLookup.end(),(unsigned long)tmin)-FrameLookup.begin();
+    unsigned long wfj=lower_bound(FrameLookup.begin(),FrameLookup.end(),(unsigned long)tmax)-FrameLookup.begin();
+    return counts.range(wfi,wfj);
+}
+
+vector<long> MosquitoesInSeq::getActivityTimeline(unsigned long n, unsigned long m, unsigned long bins, bool isTrigger /*= false*/)
+{
+    // number of positions in bins of equal width between n and m, for
+    // dynamically loaded positions the bins are of equal width in triggers
+    if(!dynamic)
+    {
+     if(m>nFrames)m=nFrames;
+     return counts.timeline(n,m,bins);
+    }
+    vector<long> tmp;
+    long tmin=n;
+    long tmax=m;
+    if(!isTrigger)
+    {
+     tmin=getTriggerFromSeq(n);
+     tmax=getTriggerFromSeq(m);
+    }
+    if(tmin<=0 || tmax<=tmin || bins==0)
+     return tmp;
+    if(bins>(unsigned long)(tmax-tmin)) bins=tmax-tmin;
+    unsigned long last=lower_bound(FrameLookup.begin(),FrameLookup.end(),(unsigned long)tmin)-FrameLookup.begin();
+    for(unsigned long b=0; b<bins; b++)
+    {
+     unsigned long e=tmin+(tmax-tmin)*(b+1)/bins;
+     unsigned long next=lower_bound(FrameLookup.begin(),FrameLookup.end(),e)-FrameLookup.begin();
+     tmp.push_back(counts.range(last,next));
+     last=next;
     }
     return tmp;
 }
@@ -437,7 +516,7 @@ vector<vector<double> > MosquitoesInSeq::getAllPosAsVector(unsigned long i, bool
     {
     if(i<nFrames)
     {
-        currentFrame=&mframes[i];
+        currentFrame=&frameAt(i);
         MosquitoPosition* currentMosquito=nullptr;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -473,7 +552,7 @@ vector<vector<double> > MosquitoesInSeq::getAllPosAsVector(unsigned long i, bool
       long wfi=findTrigger(t);
       if(wfi!=-1)
       {
-        currentFrame=&mframes[wfi];
+        currentFrame=&frameAt(wfi);
         MosquitoPosition* currentMosquito=nullptr;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -537,7 +616,15 @@ int MosquitoesInSeq::saveToFile(string filename,int saveFrom /*=-1*/, int saveTo
             if(saveTo<saveFrom) saveTo=saveFrom;
             for(unsigned long i=saveFrom; i<saveTo; i++)
             {
-                currentFrame=&mframes[i];
+                currentFrame=pagedFrame(i);
+                if(!currentFrame)
+                {
+                    // an incomplete file must not replace the positions
+                    cerr << "Error: positions of frame "<<i<<" are not available, "<<filename<<" is not saved!"<<endl;
+                    fclose(pFile);
+                    remove(filename.c_str());
+                    return 1;
+                }
                 for(int j=0; j<currentFrame->numOfMosquitoes(); j++)
                 {
                     currentMosquito=currentFrame->mosqi(j);
@@ -570,15 +657,20 @@ int MosquitoesInSeq::saveToFile(string filename,int saveFrom /*=-1*/, int saveTo
 
 int MosquitoesInSeq::loadFromFile(string filename, bool enableDynamic /* = false */, bool displayStatus /* =true */)
 {
+    journal.clear();
+    journal.setRecording(false);
     if(enableDynamic && !dynamic)
     { 
      vector<MosquitoesInFrame>().swap(mframes);
+     pager.reset();
+     counts.reset(0);
      dynamic=true;
      triggerBased=true;
     }
         
     int counter=0;
     int lastFrame=0;
+    bool failed=false;
     FILE * pFile;
     MosquitoPosition* lastMosi=nullptr;
     pFile = fopen (filename.c_str(),"r");
@@ -648,31 +740,30 @@ int MosquitoesInSeq::loadFromFile(string filename, bool enableDynamic /* = false
     if(fields==9){
         if((unsigned long)rf<nFrames || dynamic)
         {
-            if(!dynamic)
-            {
-            mframes[(unsigned long)rf].setTsSec((int)rs);
-            mframes[(unsigned long)rf].setTsMSec((unsigned short)rm);
-            mframes[(unsigned long)rf].setTsUSec((unsigned short)ru);
-            mframes[(unsigned long)rf].setFrameNo((unsigned long)rf);
-            mframes[(unsigned long)rf].setMaxDiff(rd);
-            mframes[(unsigned long)rf].addMosquito(rx,ry,ra,ri);
-            }
-            else
+            long wf=(long)rf;
+            if(dynamic)
             {
-             long wf=findTrigger((unsigned long)rf);
+             wf=findTrigger((unsigned long)rf);
              if(wf==-1)
              {
               mframes.push_back(MosquitoesInFrame());
               FrameLookup.push_back((unsigned long)rf);
               wf=mframes.size()-1;
              }
-             mframes[wf].setTsSec((int)rs);
-             mframes[wf].setTsMSec((unsigned short)rm);
-             mframes[wf].setTsUSec((unsigned short)ru);
-             mframes[wf].setFrameNo((unsigned long)rf);
-             mframes[wf].setMaxDiff(rd);
-             mframes[wf].addMosquito(rx,ry,ra,ri);
             }
+            MosquitoesInFrame* f=pagedFrame(wf);
+            if(!f)
+            {
+             cerr<<"Error: positions of frame "<<rf<<" could not be paged in, loading stopped!\n";
+             failed=true;
+             break;
+            }
+            f->setTsSec((int)rs);
+            f->setTsMSec((unsigned short)rm);
+            f->setTsUSec((unsigned short)ru);
+            f->setFrameNo((unsigned long)rf);
+            f->setMaxDiff(rd);
+            f->addMosquito(rx,ry,ra,ri);
             counter++;
             if(lastFrame<rf)
              lastFrame=rf;
@@ -705,20 +796,29 @@ int MosquitoesInSeq::loadFromFile(string filename, bool enableDynamic /* = false
     fclose(pFile);
     if(dynamic)
      sortFrames();
+    journal.setRecording(true);
+    attachJournal();
+    if(failed)
+     return -1;
     return rf;
 }
 
 int MosquitoesInSeq::loadFromFile(string filename, unsigned long rstart, unsigned long rstop , bool enableDynamic /* = false */, bool displayStatus /* =true */ )
 {
+    journal.clear();
+    journal.setRecording(false);
     if(enableDynamic && !dynamic)
     { 
      vector<MosquitoesInFrame>().swap(mframes);
+     pager.reset();
+     counts.reset(0);
      dynamic=true;
      triggerBased=true;
     }
     bool loadedLastMosq=false;    
     int counter=0;
     int lastFrame=0;
+    bool failed=false;
     FILE * pFile;
     MosquitoPosition* lastMosi=nullptr;
     pFile = fopen (filename.c_str(),"r");
@@ -788,31 +888,30 @@ int MosquitoesInSeq::loadFromFile(string filename, unsigned long rstart, unsigne
     if(fields==9){
         if(((unsigned long)rf<nFrames || dynamic) && ( (unsigned long)rf>=rstart && (unsigned long)rf<rstop))
         {
-            if(!dynamic)
-            {
-            mframes[(unsigned long)rf].setTsSec((int)rs);
-            mframes[(unsigned long)rf].setTsMSec((unsigned short)rm);
-            mframes[(unsigned long)rf].setTsUSec((unsigned short)ru);
-            mframes[(unsigned long)rf].setFrameNo((unsigned long)rf);
-            mframes[(unsigned long)rf].setMaxDiff(rd);
-            mframes[(unsigned long)rf].addMosquito(rx,ry,ra,ri);
-            }
-            else
+            long wf=(long)rf;
+            if(dynamic)
             {
-             long wf=findTrigger((unsigned long)rf);
+             wf=findTrigger((unsigned long)rf);
              if(wf==-1)
              {
               mframes.push_back(MosquitoesInFrame());
               FrameLookup.push_back((unsigned long)rf);
               wf=mframes.size()-1;
              }
-             mframes[wf].setTsSec((int)rs);
-             mframes[wf].setTsMSec((unsigned short)rm);
-             mframes[wf].setTsUSec((unsigned short)ru);
-             mframes[wf].setFrameNo((unsigned long)rf);
-             mframes[wf].setMaxDiff(rd);
-             mframes[wf].addMosquito(rx,ry,ra,ri);
             }
+            MosquitoesInFrame* f=pagedFrame(wf);
+            if(!f)
+            {
+             cerr<<"Error: positions of frame "<<rf<<" could not be paged in, loading stopped!\n";
+             failed=true;
+             break;
+            }
+            f->setTsSec((int)rs);
+            f->setTsMSec((unsigned short)rm);
+            f->setTsUSec((unsigned short)ru);
+            f->setFrameNo((unsigned long)rf);
+            f->setMaxDiff(rd);
+            f->addMosquito(rx,ry,ra,ri);
             counter++;
             if(lastFrame<rf)
              lastFrame=rf;
@@ -852,16 +951,50 @@ int MosquitoesInSeq::loadFromFile(string filename, unsigned long rstart, unsigne
     fclose(pFile);
     if(dynamic)
      sortFrames();
-     
+    journal.setRecording(true);
+    attachJournal();
+    if(failed)
+     return -1;
     return rf;
 }
 
+long MosquitoesInSeq::loadFromBackup(string filename)
+{
+    // returns the last frame which was completely written to the backup
+    if(dynamic)
+    {
+     cerr<<"Can't restore a backup into dynamically loaded positions\n";
+     return -1;
+    }
+    vector<MosquitoesInFrame> frames;
+    long last=PositionBackup::read(filename,frames);
+    journal.clear();
+    for(unsigned long i=0; i<frames.size(); i++)
+    {
+     unsigned long f=frames[i].getFrameNo();
+     if(f<nFrames)
+     {
+      MosquitoesInFrame* frame=pagedFrame(f);
+      if(!frame)
+      {
+       cerr<<"Error: positions of frame "<<f<<" could not be paged in, backup not restored!\n";
+       return -1;
+      }
+      *frame=frames[i];
+     }
+     else
+      cerr<<"Frame "<<f<<" of the backup is not part of the sequence\n";
+    }
+    cerr<<"Restored "<<frames.size()<<" frames from "<<filename<<", last frame is "<<last<<"\n";
+    return last;
+}
+
 int MosquitoesInSeq::MosqsInFrame(unsigned long f, bool isTrigger /* = false */)
 {
     if(!dynamic)
     {
-    if(f<nFrames && mframes.size()>0)
-        return mframes[f].numOfMosquitoes();
+    if(f<nFrames && f<counts.size())
+        return counts.at(f);
     else
         return 0;
     }
@@ -877,7 +1010,7 @@ int MosquitoesInSeq::MosqsInFrame(unsigned long f, bool isTrigger /* = false */)
       long wfi=findTrigger(t);
       if(wfi!=-1)
       {
-        return mframes[wfi].numOfMosquitoes();
+        return counts.at(wfi);
       }
       else
        return 0;
@@ -899,9 +1032,12 @@ int MosquitoesInSeq::clean(unsigned long i, double minDist, bool isTrigger /*= f
      if(tmp>0)
      {
       long wf=findTrigger(tmp);
+      MosquitoesInFrame* f=nullptr;
       if(wf!=-1)
+       f=pagedFrame(wf);
+      if(f)
       {
-       return mframes[wf].clean(minDist);
+       return f->clean(minDist);
       }
       else
        return 0;
@@ -909,9 +1045,12 @@ int MosquitoesInSeq::clean(unsigned long i, double minDist, bool isTrigger /*= f
     }
     else
     {
+    MosquitoesInFrame* f=nullptr;
     if(i<nFrames)
+     f=pagedFrame(i);
+    if(f)
     {
-     return mframes[i].clean(minDist);
+     return f->clean(minDist);
     } 
     else
      return 0;
@@ -930,9 +1069,12 @@ int MosquitoesInSeq::clean(unsigned long i, double minArea, double maxArea, bool
      if(tmp>0)
      {
       long wf=findTrigger(tmp);
+      MosquitoesInFrame* f=nullptr;
       if(wf!=-1)
+       f=pagedFrame(wf);
+      if(f)
       {
-         return mframes[wf].clean(minArea,maxArea);
+         return f->clean(minArea,maxArea);
       }
       else
        return 0;
@@ -940,9 +1082,12 @@ int MosquitoesInSeq::clean(unsigned long i, double minArea, double maxArea, bool
     }
     else
     { 
+    MosquitoesInFrame* f=nullptr;
     if(i<nFrames)
+     f=pagedFrame(i);
+    if(f)
     {
-         return mframes[i].clean(minArea,maxArea);
+         return f->clean(minArea,maxArea);
     }
     else
      return 0;
@@ -956,12 +1101,17 @@ int MosquitoesInSeq::giveSeqPointer(iSeq* iseq)
    return 0;
 }
 
-int MosquitoesInSeq::getTsSec(unsigned long i, bool isTrigger /* = false */)
+int MosquitoesInSeq::timeOfFrame(unsigned long i, bool isTrigger, int& sec, unsigned short& msec, unsigned short& usec)
 {
-  int ts=0;
+  // returns -1 if the frame can't be found, the time stamp stays 0 if it is unknown
+  sec=0;
+  msec=0;
+  usec=0;
+  long tr=i;
+  long seqFrame=-1;
+  long trigger=-1;
   if(!dynamic)
   {
-   long tr=i;
    if(!isTrigger)
    {
     if(triggerBased)
@@ -969,33 +1119,9 @@ int MosquitoesInSeq::getTsSec(unsigned long i, bool isTrigger /* = false */)
      long t=getTriggerFromSeq(tr);
      long wfi=findTrigger(t);
      if(wfi!=-1)
-     {
       tr=wfi;
-     }
      else
-     {
       return -1;
-     }
-    }
-    if(tr<nFrames && tr>=0)
-    {
-     if(mframes[tr].numOfMosquitoes()!=0)
-      ts=mframes[tr].getTsSec();
-     else
-     {
-      ts=mframes[tr].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-       vector<int> t=currSeq->timeOfFrameI(tr);
-       if(t.size()==3)
-       {
-         mframes[tr].setTsSec(t[0]);
-         mframes[tr].setTsMSec((unsigned short) t[1]);
-         mframes[tr].setTsUSec((unsigned short) t[2]);
-         ts=t[0];
-       }
-      }    
-     }
     }
    }
    else
@@ -1004,422 +1130,102 @@ int MosquitoesInSeq::getTsSec(unsigned long i, bool isTrigger /* = false */)
     {
      long wfi=findTrigger(tr);
      if(wfi!=-1)
-     {
       tr=wfi;
-     }
      else
-     {
       return -1;
-     } 
     }
     else
     {
-     if(haveSeq)
+     if(!haveSeq)
      {
-      if(currSeq->hasMeta())
-      {
-       int tmp=currSeq->lookUpTrigger(tr);
-       if(tmp!=-1)
-        tr=tmp;
-       else
-       {
-        cerr<<"I can't lookup the trigger, lookup failed...\n";
-        return -1;             
-       }
-      }
-      else
-      {
-       cerr<<"I can't lookup the trigger, seq does not have metadata...\n";
-       return -1;      
-      }
+      cerr<<"I can't lookup the trigger, I don't have a seq to search...\n";
+      return -1;
      }
-     else
+     if(!currSeq->hasMeta())
      {
-      cerr<<"I can't lookup the trigger, I don't have a seq to search...\n";
+      cerr<<"I can't lookup the trigger, seq does not have metadata...\n";
       return -1;
      }
-    }
-    if(tr<nFrames && tr>=0)
-    {
-     if(mframes[tr].numOfMosquitoes()!=0)
-      ts=mframes[tr].getTsSec();
-     else
+     int tmp=currSeq->lookUpTrigger(tr);
+     if(tmp==-1)
      {
-      ts=mframes[tr].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-       vector<int> t=currSeq->timeOfFrameI(tr);
-       if(t.size()==3)
-       {
-         mframes[tr].setTsSec(t[0]);
-         mframes[tr].setTsMSec((unsigned short) t[1]);
-         mframes[tr].setTsUSec((unsigned short) t[2]);
-         ts=t[0];
-       }
-      }    
+      cerr<<"I can't lookup the trigger, lookup failed...\n";
+      return -1;
      }
-    } 
+     tr=tmp;
+    }
    }
+   if(tr<0 || (unsigned long)tr>=nFrames)
+    return 0;
+   seqFrame=tr;
   }
   else
   {
-   long tr=i;
    if(!isTrigger)
    {
     long tmp=getTriggerFromSeq(tr);
-    if(tmp!=-1)
-    {
-     tr=tmp;
-    }
-    else
+    if(tmp==-1)
     {
      cerr<<"Could not translate the frame to a trigger...\n";
      return -1;
     }
+    tr=tmp;
    }
-   if(tr>0)
-   {
-    long wfi=findTrigger(tr);
-    if(wfi!=-1)
-    {
-    if(mframes[wfi].numOfMosquitoes()!=0)
-      ts=mframes[wfi].getTsSec();
-    else
-    {
-      ts=mframes[wfi].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-        int fn=currSeq->lookUpTrigger(tr);
-        if(fn!=-1)
-        {
-        vector<int> t=currSeq->timeOfFrameI(fn);
-        if(t.size()==3)
-        {
-          mframes[wfi].setTsSec(t[0]);
-          mframes[wfi].setTsMSec((unsigned short) t[1]);
-          mframes[wfi].setTsUSec((unsigned short) t[2]);
-          ts=t[0];
-        }
-        }
-      }    
-     }
-    }
-   }
+   if(tr<=0)
+    return 0;
+   long wfi=findTrigger(tr);
+   if(wfi==-1)
+    return 0;
+   trigger=tr;
+   tr=wfi;
   }
-  return ts;
-}
-
-
-unsigned short MosquitoesInSeq::getTsMSec(unsigned long i, bool isTrigger /* = false */)
-{
-  unsigned short tsm=0;
-  if(!dynamic)
+  // the time stamp is not part of the positions, so the frame is not paged in
+  MosquitoesInFrame &f=mframes[tr];
+  if(trigger!=-1 && haveSeq && counts.at(tr)==0 && f.getTsSec()==0)
+   seqFrame=currSeq->lookUpTrigger(trigger);
+  if(counts.at(tr)!=0 || f.getTsSec()!=0 || !haveSeq || seqFrame<0)
   {
-   long tr=i;
-   if(!isTrigger)
-   {
-    if(triggerBased)
-    {
-     long t=getTriggerFromSeq(tr);
-     long wfi=findTrigger(t);
-     if(wfi!=-1)
-     {
-      tr=wfi;
-     }
-     else
-     {
-      return 0;
-     }
-    }
-    if(tr<nFrames && tr>=0)
-    {
-     if(mframes[tr].numOfMosquitoes()!=0)
-      tsm=mframes[tr].getTsMSec();
-     else
-     {
-      tsm=mframes[tr].getTsMSec();
-      int ts=mframes[tr].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-       vector<int> t=currSeq->timeOfFrameI(tr);
-       if(t.size()==3)
-       {
-        mframes[tr].setTsSec(t[0]);
-        mframes[tr].setTsMSec((unsigned short) t[1]);
-        mframes[tr].setTsUSec((unsigned short) t[2]);
-        tsm=t[1];
-       }
-      }    
-     }
-    }
-   }
-   else
-   {
-    if(triggerBased)
-    {
-     long wfi=findTrigger(tr);
-     if(wfi!=-1)
-     {
-      tr=wfi;
-     }
-     else
-     {
-      return 0;
-     } 
-    }
-    else
-    {
-     if(haveSeq)
-     {
-      if(currSeq->hasMeta())
-      {
-       int tmp=currSeq->lookUpTrigger(tr);
-       if(tmp!=-1)
-        tr=tmp;
-       else
-       {
-        cerr<<"I can't lookup the trigger, lookup failed...\n";
-        return 0;             
-       }
-      }
-      else
-      {
-       cerr<<"I can't lookup the trigger, seq does not have metadata...\n";
-       return 0;      
-      }
-     }
-     else
-     {
-      cerr<<"I can't lookup the trigger, I don't have a seq to search...\n";
-      return 0;
-     }
-    }
-    if(tr<nFrames && tr>=0)
-    {
-     if(mframes[tr].numOfMosquitoes()!=0)
-      tsm=mframes[tr].getTsMSec();
-     else
-     {
-      tsm=mframes[tr].getTsMSec();
-      int ts=mframes[tr].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-       vector<int> t=currSeq->timeOfFrameI(tr);
-       if(t.size()==3)
-       {
-        mframes[tr].setTsSec(t[0]);
-        mframes[tr].setTsMSec((unsigned short) t[1]);
-        mframes[tr].setTsUSec((unsigned short) t[2]);
-        tsm=t[1];
-       }
-      }    
-     }
-    }
-   }
+   sec=f.getTsSec();
+   msec=f.getTsMSec();
+   usec=f.getTsUSec();
   }
   else
   {
-   long tr=i;
-   if(!isTrigger)
+   // only the time stamp block of this frame is read
+   vector<int> t=currSeq->timeOfFrameI(seqFrame);
+   if(t.size()==3)
    {
-    long tmp=getTriggerFromSeq(tr);
-    if(tmp!=-1)
-    {
-     tr=tmp;
-    }
-    else
-    {
-     cerr<<"Could not translate the frame to a trigger...\n";
-     return 0;
-    }
-   }
-   if(tr>0)
-   {
-    long wfi=findTrigger(tr);
-    if(wfi!=-1)
-    {
-    if(mframes[wfi].numOfMosquitoes()!=0)
-      tsm=mframes[wfi].getTsMSec();
-    else
-    {
-      tsm=mframes[wfi].getTsMSec();
-      int ts=mframes[wfi].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-        int fn=currSeq->lookUpTrigger(tr);
-        if(fn!=-1)
-        {
-        vector<int> t=currSeq->timeOfFrameI(fn);
-        if(t.size()==3)
-        {
-          mframes[wfi].setTsSec(t[0]);
-          mframes[wfi].setTsMSec((unsigned short) t[1]);
-          mframes[wfi].setTsUSec((unsigned short) t[2]);
-          tsm=t[1];
-        }
-        }
-      }    
-     }
-    }
+    sec=t[0];
+    msec=t[1];
+    usec=t[2];
    }
   }
-  return tsm;
+  return 0;
+}
+
+int MosquitoesInSeq::getTsSec(unsigned long i, bool isTrigger /* = false */)
+{
+  int sec;
+  unsigned short msec, usec;
+  if(timeOfFrame(i, isTrigger, sec, msec, usec)==-1)
+   return -1;
+  return sec;
+}
+
+unsigned short MosquitoesInSeq::getTsMSec(unsigned long i, bool isTrigger /* = false */)
+{
+  int sec;
+  unsigned short msec, usec;
+  timeOfFrame(i, isTrigger, sec, msec, usec);
+  return msec;
 }
 
 unsigned short MosquitoesInSeq::getTsUSec(unsigned long i, bool isTrigger /* = false */)
 {
-  unsigned short tsu=0;
-  if(!dynamic)
-  {
-   long tr=i;
-   if(!isTrigger)
-   {
-    if(triggerBased)
-    {
-     long t=getTriggerFromSeq(tr);
-     long wfi=findTrigger(t);
-     if(wfi!=-1)
-     {
-      tr=wfi;
-     }
-     else
-     {
-      return 0;
-     }
-    }
-    if(tr<nFrames && tr>=0)
-    {
-     if(mframes[tr].numOfMosquitoes()!=0)
-      tsu=mframes[tr].getTsUSec();
-     else
-     {
-      tsu=mframes[tr].getTsUSec();
-      int ts=mframes[tr].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-       vector<int> t=currSeq->timeOfFrameI(tr);
-       if(t.size()==3)
-       {
-        mframes[tr].setTsSec(t[0]);
-        mframes[tr].setTsMSec((unsigned short) t[1]);
-        mframes[tr].setTsUSec((unsigned short) t[2]);
-        tsu=t[2];
-       }
-      }    
-     }
-    }
-   }
-   else
-   {
-    if(triggerBased)
-    {
-     long wfi=findTrigger(tr);
-     if(wfi!=-1)
-     {
-      tr=wfi;
-     }
-     else
-     {
-      return 0;
-     } 
-    }
-    else
-    {
-     if(haveSeq)
-     {
-      if(currSeq->hasMeta())
-      {
-       int tmp=currSeq->lookUpTrigger(tr);
-       if(tmp!=-1)
-        tr=tmp;
-       else
-       {
-        cerr<<"I can't lookup the trigger, lookup failed...\n";
-        return 0;             
-       }
-      }
-      else
-      {
-       cerr<<"I can't lookup the trigger, seq does not have metadata...\n";
-       return 0;      
-      }
-     }
-     else
-     {
-      cerr<<"I can't lookup the trigger, I don't have a seq to search...\n";
-      return 0;
-     }
-    }
-    if(tr<nFrames && tr>=0)
-    {
-     if(mframes[tr].numOfMosquitoes()!=0)
-      tsu=mframes[tr].getTsUSec();
-     else
-     {
-      tsu=mframes[tr].getTsUSec();
-      int ts=mframes[tr].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-       vector<int> t=currSeq->timeOfFrameI(tr);
-       if(t.size()==3)
-       {
-        mframes[tr].setTsSec(t[0]);
-        mframes[tr].setTsMSec((unsigned short) t[1]);
-        mframes[tr].setTsUSec((unsigned short) t[2]);
-        tsu=t[2];
-       }
-      }    
-     }
-    }
-   }
-  }
-  else
-  {
-   long tr=i;
-   if(!isTrigger)
-   {
-    long tmp=getTriggerFromSeq(tr);
-    if(tmp!=-1)
-    {
-     tr=tmp;
-    }
-    else
-    {
-     cerr<<"Could not translate the frame to a trigger...\n";
-     return 0;
-    }
-   }
-   if(tr>0)
-   {
-    long wfi=findTrigger(tr);
-    if(wfi!=-1)
-    {
-    if(mframes[wfi].numOfMosquitoes()!=0)
-      tsu=mframes[wfi].getTsUSec();
-    else
-    {
-      tsu=mframes[wfi].getTsUSec();
-      int ts=mframes[wfi].getTsSec();
-      if(ts==0 && haveSeq)
-      {
-        int fn=currSeq->lookUpTrigger(tr);
-        if(fn!=-1)
-        {
-        vector<int> t=currSeq->timeOfFrameI(fn);
-        if(t.size()==3)
-        {
-          mframes[wfi].setTsSec(t[0]);
-          mframes[wfi].setTsMSec((unsigned short) t[1]);
-          mframes[wfi].setTsUSec((unsigned short) t[2]);
-          tsu=t[2];
-        }
-        }
-      }    
-     }
-    }
-   }
-  }
-  return tsu;
+  int sec;
+  unsigned short msec, usec;
+  timeOfFrame(i, isTrigger, sec, msec, usec);
+  return usec;
 }
 
 int MosquitoesInSeq::removeAll()
@@ -1430,6 +1236,10 @@ int MosquitoesInSeq::removeAll()
         for(unsigned long n=0;n<nFrames; n++)
             mframes.push_back(MosquitoesInFrame());
     }
+    journal.clear();
+    pager.reset();
+    counts.reset(mframes.size());
+    attachJournal();
     return 0;
 }
 
@@ -1442,7 +1252,10 @@ int MosquitoesInSeq::removePointsInsideOfPolygon(vector<QPointF> poly,unsigned l
     for(unsigned long i=n; i<m;i++)
      if(i<nFrames)
      {
-         num+=mframes[i].removePointsInsideOfPolygon(poly,inverse);
+         MosquitoesInFrame* f=pagedFrame(i);
+         if(!f)
+          return -1;
+         num+=f->removePointsInsideOfPolygon(poly,inverse);
      }
     }
     else
@@ -1463,7 +1276,10 @@ int MosquitoesInSeq::removePointsInsideOfPolygon(vector<QPointF> poly,unsigned l
        if(wfj==-1) wfj=wfi+1;
        for(unsigned int i=wfi; i<wfj; i++)
        {
-         num+=mframes[i].removePointsInsideOfPolygon(poly,inverse);
+         MosquitoesInFrame* f=pagedFrame(i);
+         if(!f)
+          return -1;
+         num+=f->removePointsInsideOfPolygon(poly,inverse);
        }
       }
      }
@@ -1482,13 +1298,16 @@ int MosquitoesInSeq::removePoints(double x, double y,unsigned long n, unsigned l
     for(unsigned long i=n; i<m;i++)
      if(i<nFrames)
      {
+       MosquitoesInFrame* f=pagedFrame(i);
+       if(!f)
+        return -1;
        if(!onlyOne)
-         mframes[i].removeMosquito(x,y,searchRadius,onlyOne);
+         f->removeMosquito(x,y,searchRadius,onlyOne);
        else
        {
         double dist;
         int j;
-        bool ret=mframes[i].getNearest(x,y,minDist,j,dist);
+        bool ret=f->getNearest(x,y,minDist,j,dist);
         if(ret) {
          minDist=dist;
          p=i;
@@ -1498,7 +1317,10 @@ int MosquitoesInSeq::removePoints(double x, double y,unsigned long n, unsigned l
      }
     if(p!=-1 && q!=-1)
     {
-     mframes[p].removeMosquito(q);
+     MosquitoesInFrame* f=pagedFrame(p);
+     if(!f)
+      return -1;
+     f->removeMosquito(q);
     }
   }
   else
@@ -1519,13 +1341,16 @@ int MosquitoesInSeq::removePoints(double x, double y,unsigned long n, unsigned l
        if(wfj==-1) wfj=wfi+1;
        for(unsigned int i=wfi; i<wfj; i++)
        {
+        MosquitoesInFrame* f=pagedFrame(i);
+        if(!f)
+         return -1;
         if(!onlyOne)
-         mframes[i].removeMosquito(x,y,onlyOne);       
+         f->removeMosquito(x,y,onlyOne);       
         else
         {
          double dist;
          int j;
-         bool ret=mframes[i].getNearest(x,y,minDist,j,dist);
+         bool ret=f->getNearest(x,y,minDist,j,dist);
          if(ret) {
           minDist=dist;
           p=i;
@@ -1537,7 +1362,10 @@ int MosquitoesInSeq::removePoints(double x, double y,unsigned long n, unsigned l
      }
     if(p!=-1 && q!=-1)
     {
-     mframes[p].removeMosquito(q);
+     MosquitoesInFrame* f=pagedFrame(p);
+     if(!f)
+      return -1;
+     f->removeMosquito(q);
     }      
   }
     return 0; 
@@ -1551,7 +1379,10 @@ int MosquitoesInSeq::removePoints(unsigned long n, unsigned long m, bool isTrigg
     for(unsigned long i=n; i<m;i++)
      if(i<nFrames)
      {
-         mframes[i].removeAllMosquito();
+         MosquitoesInFrame* f=pagedFrame(i);
+         if(!f)
+          return -1;
+         f->removeAllMosquito();
      }
   }
   else
@@ -1572,7 +1403,10 @@ int MosquitoesInSeq::removePoints(unsigned long n, unsigned long m, bool isTrigg
        if(wfj==-1) wfj=wfi+1;
        for(unsigned int i=wfi; i<wfj; i++)
        {
-         mframes[i].removeAllMosquito();       
+         MosquitoesInFrame* f=pagedFrame(i);
+         if(!f)
+          return -1;
+         f->removeAllMosquito();
        }
       }
      }
@@ -1590,7 +1424,7 @@ vector<cv::Point2f> MosquitoesInSeq::pointsInsideOfPolygon(vector<QPointF> poly,
     for(unsigned long i=n; i<m;i++)
      if(i<nFrames)
      {
-         vector<cv::Point2f> tmp=mframes[i].pointsInsideOfPolygon(poly);
+         vector<cv::Point2f> tmp=frameAt(i).pointsInsideOfPolygon(poly);
          for(unsigned int j=0; j<tmp.size(); j++)
           listOfPoints.push_back(tmp[j]);
      }
@@ -1613,7 +1447,7 @@ vector<cv::Point2f> MosquitoesInSeq::pointsInsideOfPolygon(vector<QPointF> poly,
        if(wfj==-1) wfj=wfi+1;
        for(unsigned int i=wfi; i<wfj; i++)
        {
-         vector<cv::Point2f> tmp=mframes[i].pointsInsideOfPolygon(poly);
+         vector<cv::Point2f> tmp=frameAt(i).pointsInsideOfPolygon(poly);
          for(unsigned int j=0; j<tmp.size(); j++)
           listOfPoints.push_back(tmp[j]);       
        }
@@ -1628,7 +1462,7 @@ unsigned long MosquitoesInSeq::getFirstFrameWithMosquito()
  unsigned long f=0;
  for (unsigned int i=0; i<nFrames; i++)
  {
-  if(mframes[i].numOfMosquitoes()!=0)
+  if(frameAt(i).numOfMosquitoes()!=0)
   {
    f=i;
    break;
@@ -1646,7 +1480,7 @@ unsigned long MosquitoesInSeq::getLastFrameWithMosquito()
  unsigned long l=0;
  for (int i=nFrames-1; i>=0; i--)
  {
-  if(mframes[i].numOfMosquitoes()!=0)
+  if(frameAt(i).numOfMosquitoes()!=0)
   {
    l=i;
    break;
@@ -1678,9 +1512,9 @@ vector<unsigned long> MosquitoesInSeq::findMosquito(QPointF p,unsigned long n, u
     for(unsigned long i=n; i<m;i++)
      if(i<nFrames)
      {
-         for(unsigned int j=0; j<mframes[i].numOfMosquitoes(); j++)
+         for(unsigned int j=0; j<frameAt(i).numOfMosquitoes(); j++)
          {
-          MosquitoPosition* tmp=mframes[i].mosqi(j);
+          MosquitoPosition* tmp=frameAt(i).mosqi(j);
           double dist=sqrt(pow(tmp->getX()-p.x(),2)+pow(tmp->getY()-p.y(),2));
           if(dist<distance)
           {
@@ -1710,9 +1544,9 @@ vector<unsigned long> MosquitoesInSeq::findMosquito(QPointF p,unsigned long n, u
        if(wfj==-1) wfj=wfi+1;
        for(unsigned int i=wfi; i<wfj; i++)
        {
-         for(unsigned int j=0; j<mframes[i].numOfMosquitoes(); j++)
+         for(unsigned int j=0; j<frameAt(i).numOfMosquitoes(); j++)
          {
-          MosquitoPosition* tmp=mframes[i].mosqi(j);
+          MosquitoPosition* tmp=frameAt(i).mosqi(j);
           double dist=sqrt(pow(tmp->getX()-p.x(),2)+pow(tmp->getY()-p.y(),2));
           if(dist<distance)
           {
@@ -1749,6 +1583,7 @@ bool MosquitoesInSeq::copyTo(MosquitoesInSeq& a)
     a.nFrames=nFrames;
     if(a.initialized)
     {
+      pager.loadAll(mframes);
       vector<MosquitoesInFrame>().swap(a.mframes);  
       for(unsigned long i=0; i<nFrames; i++)
           a.mframes.push_back(mframes[i]);
@@ -1756,15 +1591,108 @@ bool MosquitoesInSeq::copyTo(MosquitoesInSeq& a)
     a.dynamic=dynamic;
     a.triggerBased=triggerBased;
     a.FrameLookup=FrameLookup;
+    a.journal.clear();
+    a.pager=pager;
+    a.counts=counts;
+    a.attachJournal();
+    return true;
+}
+
+void MosquitoesInSeq::beginUndoStep(unsigned long maxSteps)
+{
+    journal.beginStep(maxSteps);
+}
+
+void MosquitoesInSeq::setJournaling(bool b)
+{
+    // bulk changes such as a segmentation run are not journaled; the history
+    // is dropped, as its steps would not fit the positions afterwards
+    if(!b)
+     journal.clear();
+    journal.setRecording(b);
+}
+
+bool MosquitoesInSeq::undo()
+{
+    if(!journal.canUndo())
+     return false;
+    vector<positionDelta> step=journal.popUndo();
+    if(!applyStep(step,true))
+    {
+     journal.pushUndo(step);
+     return false;
+    }
+    journal.pushRedo(step);
     return true;
 }
 
+bool MosquitoesInSeq::redo()
+{
+    if(!journal.canRedo())
+     return false;
+    vector<positionDelta> step=journal.popRedo();
+    if(!applyStep(step,false))
+    {
+     journal.pushRedo(step);
+     return false;
+    }
+    journal.pushUndo(step);
+    return true;
+}
+
+bool MosquitoesInSeq::applyStep(const vector<positionDelta>& step, bool inverse)
+{
+    // the frames must not record their own undo; a frame which cannot be
+    // paged in fails the whole step, the frames changed before it are set back
+    journal.setRecording(false);
+    bool ok=true;
+    unsigned long i=step.size();
+    for(; i>0; i--)
+    {
+     const positionDelta &d=step[i-1];
+     if(d.frame>=mframes.size())
+     {
+      cerr<<"Undo step refers to frame "<<d.frame<<" which does not exist\n";
+      continue;
+     }
+     MosquitoesInFrame* f=pagedFrame(d.frame);
+     if(!f)
+     {
+      cerr<<"Error: positions of frame "<<d.frame<<" could not be paged in, the step is not applied!\n";
+      ok=false;
+      break;
+     }
+     f->removeBySlot(inverse?d.added:d.removed);
+     f->insertBySlot(inverse?d.removed:d.added);
+    }
+    if(!ok)
+     for(unsigned long j=i; j<step.size(); j++)
+     {
+      const positionDelta &d=step[j];
+      MosquitoesInFrame* f=d.frame<mframes.size()?pagedFrame(d.frame):nullptr;
+      if(!f)
+       continue;
+      f->removeBySlot(inverse?d.removed:d.added);
+      f->insertBySlot(inverse?d.added:d.removed);
+     }
+    journal.setRecording(true);
+    return ok;
+}
+
+void MosquitoesInSeq::attachJournal()
+{
+    for(unsigned long i=0; i<mframes.size(); i++)
+     mframes[i].setJournal(&journal,i,&counts);
+}
+
 bool MosquitoesInSeq::resetFlags()
 {
     MosquitoesInFrame* currentFrame=nullptr;
     for(unsigned long i=0; i<nFrames;i++)
     {
-        currentFrame=&mframes[i];
+        currentFrame=pagedFrame(i);
+        if(!currentFrame)
+         return false;
         MosquitoPosition* currentMosquito=nullptr;
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
@@ -1789,7 +1717,7 @@ vector<vector<cv::Point> > MosquitoesInSeq::getContours(unsigned long i, unsigne
      {
       if(n<nFrames)
       {
-        currentFrame=&mframes[n];
+        currentFrame=&frameAt(n);
         for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
         {
           MosquitoPosition* currentMosquito=nullptr; 
@@ -1824,7 +1752,7 @@ vector<vector<cv::Point> > MosquitoesInSeq::getContours(unsigned long i, unsigne
      if(wfj==-1) wfj=wfi+1;
      for(unsigned int n=wfi; n<wfj; n++)
      {
-      currentFrame=&mframes[n];
+      currentFrame=&frameAt(n);
       for(int ii=0; ii<currentFrame->numOfMosquitoes(); ii++)
       {
        MosquitoPosition* currentMosquito=nullptr; 
@@ -1858,6 +1786,7 @@ void MosquitoesInSeq::sortFrames()
 {
  //sort mframes and FrameLookup
  vector<pair<unsigned long,MosquitoesInFrame> > tmp;
+ pager.loadAll(mframes);
  //zip
  for(unsigned i=0; i<FrameLookup.size(); i++)
   tmp.push_back(make_pair(FrameLookup[i],mframes[i]));
@@ -1870,6 +1799,11 @@ void MosquitoesInSeq::sortFrames()
   mframes[i] = tmp[i].second;
  }
  nFrames=mframes.size();
+ // frames of the new file were added before they were attached to the counts
+ counts.reset(0);
+ for(unsigned long i=0; i<mframes.size(); i++)
+  counts.push_back(mframes[i].numOfMosquitoes());
+ pager.reset();
 }
 
 vector<unsigned long> MosquitoesInSeq::getTriggerRange()
@@ -1962,9 +1896,12 @@ bool MosquitoesInSeq::fixTime()
 {
  if(haveSeq && currSeq)
  {
+  // all time stamps are needed, the table reads them in one go and keeps them for the next opening
+  TimestampTable* ts=currSeq->timestampTable();
   for(int i=0; i<nFrames; i++)
   {
-   vector<int> ttt=currSeq->timeOfFrameI(i);
+   vector<int> ttt=ts->at(i);
+   // the time stamps of a frame stay in memory when its positions are paged out
    mframes[i].setTime(ttt);
   }
  }
@@ -1980,7 +1917,10 @@ int MosquitoesInSeq::removeMarkedMosquitoes(unsigned long n, unsigned long m, bo
     for(unsigned long i=n; i<m;i++)
      if(i<nFrames)
      {
-         mframes[i].removeMarkedMosquitoes();
+         MosquitoesInFrame* f=pagedFrame(i);
+         if(!f)
+          return -1;
+         f->removeMarkedMosquitoes();
      }
   }
   else
@@ -2001,7 +1941,10 @@ int MosquitoesInSeq::removeMarkedMosquitoes(unsigned long n, unsigned long m, bo
        if(wfj==-1) wfj=wfi+1;
        for(unsigned int i=wfi; i<wfj; i++)
        {
-         mframes[i].removeMarkedMosquitoes();       
+         MosquitoesInFrame* f=pagedFrame(i);
+         if(!f)
+          return -1;
+         f->removeMarkedMosquitoes();
        }
       }
      }
@@ -2013,14 +1956,24 @@ int MosquitoesInSeq::removeMarkedMosquitoes(unsigned long n, unsigned long m, bo
 void MosquitoesInSeq::contourStatistics()
 {
     for(unsigned long i=0;i<mframes.size();i++)
-     mframes[i].contourStatistics();
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return;
+     f->contourStatistics();
+    }
 }
 
 int MosquitoesInSeq::filterByArea(double A, bool invert /*= false*/)
 {
     int nRem=0;
     for(unsigned long i=0;i<mframes.size();i++)
-     nRem+=mframes[i].filterByArea(A, invert);
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return -1;
+     nRem+=f->filterByArea(A, invert);
+    }
     return nRem;
 }
 
@@ -2028,7 +1981,12 @@ int MosquitoesInSeq::filterByMaxInt(double I, bool invert /*= false*/)
 {
     int nRem=0;
     for(unsigned long i=0;i<mframes.size();i++)
-     nRem+=mframes[i].filterByMaxInt(I, invert);
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return -1;
+     nRem+=f->filterByMaxInt(I, invert);
+    }
     return nRem;
 }
 
@@ -2036,7 +1994,12 @@ int MosquitoesInSeq::filterByCircularity(double I, bool invert /*= false*/)
 {
     int nRem=0;
     for(unsigned long i=0;i<mframes.size();i++)
-     nRem+=mframes[i].filterByCircularity(I, invert);
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return -1;
+     nRem+=f->filterByCircularity(I, invert);
+    }
     return nRem;
 }
 
@@ -2044,7 +2007,12 @@ int MosquitoesInSeq::filterByInertia(double I, bool invert /*= false*/)
 {
     int nRem=0;
     for(unsigned long i=0;i<mframes.size();i++)
-     nRem+=mframes[i].filterByInertia(I, invert);
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return -1;
+     nRem+=f->filterByInertia(I, invert);
+    }
     return nRem;
 }
 
@@ -2052,7 +2020,12 @@ int MosquitoesInSeq::filterByConvexity(double I, bool invert /*= false*/)
 {
     int nRem=0;
     for(unsigned long i=0;i<mframes.size();i++)
-     nRem+=mframes[i].filterByConvexity(I, invert);
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return -1;
+     nRem+=f->filterByConvexity(I, invert);
+    }
     return nRem;
 }
 
@@ -2060,14 +2033,30 @@ int MosquitoesInSeq::filterByRadius(double I, bool invert /*= false*/)
 {
     int nRem=0;
     for(unsigned long i=0;i<mframes.size();i++)
-     nRem+=mframes[i].filterByConvexity(I, invert);
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return -1;
+     nRem+=f->filterByConvexity(I, invert);
+    }
     return nRem;
 }
 
 void MosquitoesInSeq::setKeepMeFlag(bool b)
 {
     for(unsigned long i=0;i<mframes.size();i++)
-     mframes[i].setKeepMeFlag(b);
+    {
+     MosquitoesInFrame* f=pagedFrame(i);
+     if(!f)
+      return;
+     f->setKeepMeFlag(b);
+    }
+}
+
+bool MosquitoesInSeq::setMemoryBudget(unsigned long MB, string pageFile /* = string() */)
+{
+    // 0 keeps all positions in memory
+    return pager.setBudget(mframes, MB, pageFile);
 }
 
 vector<vector<double> >  MosquitoesInSeq::pointsInsideOfPolygonAsVector(vector<QPointF> poly,unsigned long n, unsigned long m, bool isTrigger /* = false */)
@@ -2079,7 +2068,7 @@ vector<vector<double> >  MosquitoesInSeq::pointsInsideOfPolygonAsVector(vector<Q
     for(unsigned long i=n; i<m;i++)
      if(i<nFrames)
      {
-         vector<vector<double> > tmp=mframes[i].pointsInsideOfPolygonAsVector(poly);
+         vector<vector<double> > tmp=frameAt(i).pointsInsideOfPolygonAsVector(poly);
          listOfPoints.insert(listOfPoints.end(), tmp.begin(), tmp.end());
      }
     }
@@ -2101,7 +2090,7 @@ vector<vector<double> >  MosquitoesInSeq::pointsInsideOfPolygonAsVector(vector<Q
        if(wfj==-1) wfj=wfi+1;
        for(unsigned int i=wfi; i<wfj; i++)
        {
-         vector<vector<double> > tmp=mframes[i].pointsInsideOfPolygonAsVector(poly);
+         vector<vector<double> > tmp=frameAt(i).pointsInsideOfPolygonAsVector(poly);
          listOfPoints.insert(listOfPoints.end(), tmp.begin(), tmp.end());
        }
       }
@@ -19,6 +19,7 @@
 #ifndef MOSQUITOESINSEQ_hpp
 #define MOSQUITOESINSEQ_hpp
 #include "MosquitoesInFrame.hpp"
+#include "PositionPager.hpp"
 #include <vector>
 //opencv
 #if CV_MAJOR_VERSION < 3
@@ -76,8 +77,11 @@ public:
     vector<double> getPointMeta(unsigned long n, bool isTrigger = false);
     vector<vector<double> > getAllPosAsVector(unsigned long i, bool isTrigger = false);
     int getNumOfAllPos();
+    long countInRange(unsigned long n, unsigned long m, bool isTrigger = false);
+    vector<long> getActivityTimeline(unsigned long n, unsigned long m, unsigned long bins, bool isTrigger = false);
     int loadFromFile(string filename, bool enableDynamic = false, bool displayStatus  = false );
     int loadFromFile(string filename, unsigned long rstart, unsigned long rstop , bool enableDynamic = false, bool displayStatus = false );
+    long loadFromBackup(string filename);
     int saveToFile(string filename, int saveFrom = -1, int saveTo = -1);
     int MosqsInFrame(unsigned long f, bool isTrigger = false);
     int giveSeqPointer(iSeq* iseq);
@@ -92,6 +96,12 @@ public:
     vector<vector<double> > pointsInsideOfPolygonAsVector(vector<QPointF> poly,unsigned long n, unsigned long m, bool isTrigger = false);
     vector<unsigned long> findMosquito(QPointF p,unsigned long n, unsigned long m, bool isTrigger = false);
     bool copyTo(MosquitoesInSeq& a); 
+    void beginUndoStep(unsigned long maxSteps);
+    bool undo();
+    bool redo();
+    bool canUndo(){return journal.canUndo();};
+    bool canRedo(){return journal.canRedo();};
+    void setJournaling(bool b);
     bool resetFlags();
     vector<vector<cv::Point> > getContours(unsigned long i, unsigned long j=0, bool isTrigger = false);
     bool isDynamic();
@@ -109,12 +119,27 @@ public:
     int filterByConvexity(double I, bool invert = false);
     int filterByRadius(double I, bool invert = false);
     void setKeepMeFlag(bool b);
+    bool setMemoryBudget(unsigned long MB, string pageFile = string());
+    unsigned long getMemoryBudget(){return pager.getBudget();};
 private:
     void sortFrames();
     long findTrigger(unsigned long tmp);
     long findTriggerNearest(unsigned long tmp, bool next=true);
     long getTriggerFromSeq(unsigned long i);
+    int timeOfFrame(unsigned long i, bool isTrigger, int& sec, unsigned short& msec, unsigned short& usec);
+    void attachJournal();
+    bool applyStep(const vector<positionDelta>& step, bool inverse);
+    // all access to the positions of a frame goes through frameAt() or pagedFrame(), so the pager can bring them back from disk;
+    // frameAt() is for reading only, a frame which could not be read back from the page file reads as empty
+    MosquitoesInFrame& frameAt(unsigned long i){pager.touch(mframes,i); return mframes[i];};
+    // nullptr if the positions of the frame could not be read back from the page file, all changes go through here
+    MosquitoesInFrame* pagedFrame(unsigned long i){return pager.touch(mframes,i)?&mframes[i]:nullptr;};
     vector<MosquitoesInFrame> mframes;
+    PositionPager pager;
+    // number of positions per frame, kept up to date by the frames
+    DetectionCounts counts;
+    // undo history of the position edits, frames are referenced by their index into mframes
+    PositionJournal journal;
     unsigned long nFrames;
     int initialized;
     iSeq* currSeq;
@@ -60,46 +60,252 @@ MyVideoReader::MyVideoReader()
     video_dec_ctx = NULL;
     video_stream = NULL;
     audio_stream = NULL;
-
+    decodeThreads = VIDEODECODETHREADS;
+    decodeThreadType = VIDEODECODETHREADTYPE;
+    previewLowres = -1;
+    draining = false;
+    decodedNumber = -1;
+    skipBefore = 0;
+    aheadDepth = VIDEODECODEAHEAD;
+    aheadRunning = false;
+    aheadStop = false;
+    aheadEnd = false;
+    cache.setBudget(VIDEOFRAMECACHEMB);
+    fromCache = false;
+    cacheNext = 0;
+    keepGrabbed = false;
+    cacheTarget = false;
+    grabbedStream = -1;
 }
 
 MyVideoReader::~MyVideoReader()
 {
+    stopAhead();
+    clearReorder();
+    freeFrames();
     if(video_dec_ctx)
         avcodec_free_context(&video_dec_ctx);
     avformat_close_input(&fmt_ctx);
     av_frame_free(&frame);
-    av_free(video_dst_data[0]);
 }
 
 int MyVideoReader::getNext(Image<unsigned char>& img)
 {
-    if(av_read_frame(fmt_ctx, &pkt) >= 0) {
-        AVPacket orig_pkt = pkt;
-        do {
-            ret = decode_packet(&got_frame, 0);
-            if (ret < 0)
-                break;
-            pkt.data += ret;
-            pkt.size -= ret;
-        } while (pkt.size > 0);
-        if(!img.hasBuffer())
+    if(!img.hasBuffer())
+    {
+       img.create(width, height);
+    }
+    else if(!(img.getX()==width && img.getY()==height))
+    {
+       img.create(width, height);
+    }
+    if(fromCache)
+    {
+        // frames after a cached one come from the cache as long as it has them
+        if(cache.get(cacheNext, img.buffer, (size_t)width*height))
         {
-           img.create(width, height);
+            frame_number = cacheNext++;
+            img.setT(frame_number/get_fps());
+            return 0;
         }
-        else if(!(img.getX()==width && img.getY()==height))
+        fromCache = false;
+        seekDecoder(cacheNext);
+    }
+    DecodedFrame f;
+    if(!nextDecoded(f))
+        return 1;
+    // the only copy of a frame, straight from the luma plane of the decoder
+    const uint8_t* src = f.pic->data[0];
+    int linesize = f.pic->linesize[0];
+    if(linesize == width)
+        memcpy(img.buffer, src, (size_t)width*height);
+    else
+        for(int y = 0; y < height; y++)
+            memcpy(img.buffer+(size_t)y*width, src+(size_t)y*linesize, width);
+    picture_pts = f.pts;
+    frame_number = f.number;
+    double timestamp=frame_number/get_fps();
+    img.setT(timestamp);
+    // sequential reads, e.g. for the segmentation, do not pay for a second copy;
+    // only the target of a seek joins the frames decoded on the way to it
+    if(cacheTarget)
+    {
+        cache.put(frame_number, img.buffer, width, width, height);
+        cacheTarget = false;
+    }
+    releaseFrame(f.pic);
+    return 0;
+}
+
+bool MyVideoReader::decodeFrame(DecodedFrame& f)
+{
+    // B-frames leave the decoder later than they went in, frames are handed out
+    // in pts order once more than has_b_frames are waiting, I/P streams at once
+    for(;;)
+    {
+        int depth = video_dec_ctx->has_b_frames;
+        if(!reorder.empty() && (draining || (int)reorder.size() > depth))
         {
-           img.create(width, height);
+            size_t first = 0;
+            for(size_t i = 1; i < reorder.size(); i++)
+                if(reorder[i].pts < reorder[first].pts)
+                    first = i;
+            f = reorder[first];
+            reorder.erase(reorder.begin()+first);
+            if(f.pts != AV_NOPTS_VALUE && first_frame_number >= 0)
+                f.number = dts_to_frame_number(f.pts) - first_frame_number;
+            else
+                f.number = decodedNumber+1;
+            decodedNumber = f.number;
+            return true;
         }
-        picture_pts=orig_pkt.pts;        
-        memcpy(img.buffer,video_dst_data[0],width*height);
-        frame_number = dts_to_frame_number(picture_pts) - first_frame_number;
-        double timestamp=frame_number/get_fps();
-        img.setT(timestamp);
-        av_packet_unref(&orig_pkt);
-        return 0;
+        if(draining)
+            return false;
+        if(av_read_frame(fmt_ctx, &pkt) < 0)
+        {
+            draining = true;
+            decode_packet(NULL, true);
+            continue;
+        }
+        if(pkt.stream_index == video_stream_idx)
+            decode_packet(&pkt, true);
+        av_packet_unref(&pkt);
+    }
+}
+
+bool MyVideoReader::decodeWanted(DecodedFrame& f)
+{
+    // frames before the last seek target are only decoded as references
+    for(;;)
+    {
+        if(!decodeFrame(f))
+            return false;
+        if(f.number >= skipBefore)
+            return true;
+        cache.put(f.number, f.pic->data[0], f.pic->linesize[0], width, height);
+        releaseFrame(f.pic);
+    }
+}
+
+void MyVideoReader::clearReorder()
+{
+    for(size_t i = 0; i < reorder.size(); i++)
+        releaseFrame(reorder[i].pic);
+    reorder.clear();
+}
+
+bool MyVideoReader::nextDecoded(DecodedFrame& f)
+{
+    if(aheadDepth <= 0)
+        return decodeWanted(f);
+    startAhead();
+    unique_lock<mutex> lock(aheadMutex);
+    while(ahead.empty() && !aheadEnd)
+        aheadCond.wait(lock);
+    if(ahead.empty())
+        return false;
+    f = ahead.front();
+    ahead.pop_front();
+    aheadCond.notify_all();
+    return true;
+}
+
+AVFrame* MyVideoReader::takeFrame()
+{
+    lock_guard<mutex> lock(aheadMutex);
+    if(spare.empty())
+        return av_frame_alloc();
+    AVFrame* p = spare.back();
+    spare.pop_back();
+    return p;
+}
+
+void MyVideoReader::releaseFrame(AVFrame* p)
+{
+    // the planes go back to the decoder, the AVFrame is kept for the next frame
+    av_frame_unref(p);
+    lock_guard<mutex> lock(aheadMutex);
+    spare.push_back(p);
+}
+
+void MyVideoReader::freeFrames()
+{
+    lock_guard<mutex> lock(aheadMutex);
+    for(size_t i = 0; i < spare.size(); i++)
+        av_frame_free(&spare[i]);
+    spare.clear();
+}
+
+void MyVideoReader::aheadLoop()
+{
+    for(;;)
+    {
+        {
+            unique_lock<mutex> lock(aheadMutex);
+            while(!aheadStop && (int)ahead.size() >= aheadDepth)
+                aheadCond.wait(lock);
+            if(aheadStop)
+                return;
+        }
+        DecodedFrame f;
+        bool ok = decodeWanted(f);
+        lock_guard<mutex> lock(aheadMutex);
+        if(!ok)
+        {
+            aheadEnd = true;
+            aheadCond.notify_all();
+            return;
+        }
+        ahead.push_back(f);
+        aheadCond.notify_all();
+    }
+}
+
+void MyVideoReader::startAhead()
+{
+    if(aheadRunning)
+        return;
+    aheadStop = false;
+    aheadEnd = false;
+    aheadRunning = true;
+    aheadThread = thread(&MyVideoReader::aheadLoop, this);
+}
+
+void MyVideoReader::stopAhead()
+{
+    // the demuxer and decoder belong to the calling thread again afterwards
+    if(!aheadRunning)
+        return;
+    {
+        lock_guard<mutex> lock(aheadMutex);
+        aheadStop = true;
+    }
+    aheadCond.notify_all();
+    aheadThread.join();
+    aheadRunning = false;
+    aheadStop = false;
+    aheadEnd = false;
+    while(!ahead.empty())
+    {
+        releaseFrame(ahead.front().pic);
+        ahead.pop_front();
+    }
+}
+
+void MyVideoReader::setDecoding(int threads, int type, int _ahead)
+{
+    // a changed thread setup reopens the decoder, the next frame has to be sought
+    stopAhead();
+    bool reopen = isReady && video_dec_ctx && (threads != decodeThreads || type != decodeThreadType);
+    decodeThreads = threads < 0 ? 0 : threads;
+    decodeThreadType = type;
+    aheadDepth = _ahead < 0 ? 0 : _ahead;
+    if(reopen)
+    {
+        avcodec_free_context(&video_dec_ctx);
+        if (open_codec_context(&video_stream_idx, &video_dec_ctx, fmt_ctx, AVMEDIA_TYPE_VIDEO) < 0)
+            isReady = 0;
     }
-    return 1; 
 }
 
 int MyVideoReader::open_codec_context(int *stream_idx,
@@ -136,6 +342,14 @@ int MyVideoReader::open_codec_context(int *stream_idx,
             return ret;
         }
         av_dict_set(&opts, "refcounted_frames", refcount ? "1" : "0", 0);
+        (*dec_ctx)->thread_count = decodeThreads;
+        (*dec_ctx)->thread_type = decodeThreadType;
+        if (previewLowres >= 0) {
+            // preview frames are only looked at, not segmented
+            (*dec_ctx)->skip_loop_filter = AVDISCARD_ALL;
+            (*dec_ctx)->flags2 |= AV_CODEC_FLAG2_FAST;
+            (*dec_ctx)->lowres = FFMIN(previewLowres, (int)dec->max_lowres);
+        }
         if ((ret = avcodec_open2(*dec_ctx, dec, &opts)) < 0) {
             fprintf(stderr, "Failed to open %s codec\n",
                     av_get_media_type_string(type));
@@ -146,20 +360,26 @@ int MyVideoReader::open_codec_context(int *stream_idx,
     return 0;
 }
 
-int MyVideoReader::decode_packet(int *got_frame, int cached)
+int MyVideoReader::decode_packet(AVPacket* p, bool keep)
 {
-    ret = 0;
-    int decoded = pkt.size;
-    *got_frame = 0;
-    if (pkt.stream_index == video_stream_idx) {
-        ret = avcodec_decode_video2(video_dec_ctx, frame, got_frame, &pkt);
-        if (ret < 0) {
+    // NULL drains the decoder, kept frames go to the reorder buffer
+    int received = 0;
+    for(int attempt = 0; attempt < 2; attempt++) {
+        // a full decoder takes the packet again once its frames are received
+        ret = avcodec_send_packet(video_dec_ctx, p);
+        bool again = ret == AVERROR(EAGAIN);
+        if (ret < 0 && !again && ret != AVERROR_EOF) {
             fprintf(stderr, "Error decoding video frame (%d)\n", ret);
             return ret;
         }
-
-        if (*got_frame) {
-
+        for(;;) {
+            ret = avcodec_receive_frame(video_dec_ctx, frame);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            if (ret < 0) {
+                fprintf(stderr, "Error decoding video frame (%d)\n", ret);
+                return ret;
+            }
             if (frame->width != width || frame->height != height ||
                 frame->format != pix_fmt) {
                 fprintf(stderr, "Error: Width, height and pixel format have to be "
@@ -170,22 +390,27 @@ int MyVideoReader::decode_packet(int *got_frame, int cached)
                         width, height, av_get_pix_fmt_name(pix_fmt),
                         frame->width, frame->height,
                         av_get_pix_fmt_name((AVPixelFormat)frame->format));
+                av_frame_unref(frame);
                 return -1;
             }
-            if(cached==0)
-               av_image_copy(video_dst_data, video_dst_linesize,
-                          (const uint8_t **)(frame->data), frame->linesize,
-                          pix_fmt, width, height);
-            
-        }
-        else{
-            cout << "Not got Frame..."<<endl;        
+            if (keep) {
+                DecodedFrame d;
+                d.pts = frame->best_effort_timestamp;
+                if (d.pts == AV_NOPTS_VALUE)
+                    d.pts = frame->pkt_dts;
+                d.number = -1;
+                d.pic = takeFrame();
+                av_frame_move_ref(d.pic, frame);
+                reorder.push_back(d);
+            }
+            else
+                av_frame_unref(frame);
+            received++;
         }
-    } 
-
-    if (*got_frame && refcount)
-        av_frame_unref(frame);
-    return decoded;
+        if (!again)
+            break;
+    }
+    return received;
 }
 
 int64_t MyVideoReader::get_total_frames()
@@ -224,6 +449,62 @@ double MyVideoReader::get_fps()
 void MyVideoReader::seek(int64_t _frame_number)
 {
     _frame_number = std::min(_frame_number, get_total_frames());
+    fromCache = cache.has(_frame_number);
+    if(fromCache)
+    {
+        cacheNext = _frame_number;
+        frame_number = _frame_number;
+        return;
+    }
+    seekDecoder(_frame_number);
+}
+
+void MyVideoReader::seekDecoder(int64_t _frame_number)
+{
+    stopAhead();
+    draining = false;
+    clearReorder();
+    skipBefore = _frame_number;
+    cacheTarget = true;
+    if(!seekToKeyframe(_frame_number))
+        seekByGuess(_frame_number);
+}
+
+bool MyVideoReader::seekToKeyframe(int64_t _frame_number)
+{
+    // jump to the keyframe before the frame and decode only the packets up to it
+    long p = keyframes.packetOf(_frame_number);
+    long k = keyframes.keyBefore(p);
+    if( p < 0 || k < 0 )
+        return false;
+    if( av_seek_frame(fmt_ctx, video_stream_idx, keyframes.ptsOf(k), AVSEEK_FLAG_BACKWARD) < 0 )
+        return false;
+    avcodec_flush_buffers(video_dec_ctx);
+    // the frames decoded on the way are kept for the cache
+    keepGrabbed = cache.getBudget() > 0;
+    for(long i = k; i < p; )
+    {
+        // only packets of the video stream are counted and compared
+        bool ok = grabFrame();
+        if( grabbedStream == video_stream_idx && ok && ( i != k || picture_pts == keyframes.ptsOf(k) ) )
+        {
+            i++;
+            continue;
+        }
+        if( grabbedStream < 0 || grabbedStream == video_stream_idx )
+        {
+            keepGrabbed = false;
+            clearReorder();
+            return false;
+        }
+    }
+    keepGrabbed = false;
+    frame_number = _frame_number;
+    return true;
+}
+
+void MyVideoReader::seekByGuess(int64_t _frame_number)
+{
     int delta = 16;
     for(;;)
     {
@@ -241,9 +522,6 @@ void MyVideoReader::seek(int64_t _frame_number)
             if( _frame_number > 1 )
             {
                 frame_number = dts_to_frame_number(picture_pts) - first_frame_number;
-                printf("_frame_number = %d, frame_number = %d, delta = %d\n",
-                       (int)_frame_number, (int)frame_number, delta);
-
                 if( frame_number < 0 || frame_number > _frame_number-1 )
                 {
                     if( _frame_number_temp == 0 || delta >= INT_MAX/4 )
@@ -299,16 +577,13 @@ bool MyVideoReader::grabFrame()
 {
     bool valid=false;
     picture_pts = AV_NOPTS_VALUE;
+    grabbedStream = -1;
 
     if(av_read_frame(fmt_ctx, &pkt) >= 0) {
         AVPacket orig_pkt = pkt;
-        do {
-            ret = decode_packet(&got_frame, 1);
-            if (ret < 0)
-                break;
-            pkt.data += ret;
-            pkt.size -= ret;
-            } while (pkt.size > 0);
+        grabbedStream = pkt.stream_index;
+        if (pkt.stream_index == video_stream_idx)
+            decode_packet(&pkt, keepGrabbed);
         if( picture_pts == AV_NOPTS_VALUE )
             picture_pts = pkt.pts != AV_NOPTS_VALUE && pkt.pts != 0 ? pkt.pts : pkt.dts;
         frame_number++;
@@ -340,9 +615,74 @@ int MyVideoReader::isOpened()
     return isReady;
 }
 
+string MyVideoReader::keyframeName()
+{
+    return filename+".keyframes";
+}
+
+void MyVideoReader::indexKeyframes()
+{
+    // packets of the video stream, read once without decoding
+    keyframes.clear();
+    if(!video_stream)
+        return;
+    if(keyframes.recall(filename))
+        return;
+    if(keyframes.load(keyframeName(), filename))
+    {
+        keyframes.remember(filename);
+        return;
+    }
+    AVPacket p;
+    av_init_packet(&p);
+    p.data = NULL;
+    p.size = 0;
+    bool anyKey = false;
+    while(av_read_frame(fmt_ctx, &p) >= 0) {
+        if (p.stream_index == video_stream_idx) {
+            int64_t ts = p.pts != AV_NOPTS_VALUE && p.pts != 0 ? p.pts : p.dts;
+            bool key = (p.flags & AV_PKT_FLAG_KEY) != 0;
+            keyframes.add(ts, p.pos, key);
+            anyKey = anyKey || key;
+        }
+        av_packet_unref(&p);
+    }
+    int64_t start = video_stream->start_time == AV_NOPTS_VALUE ? 0 : video_stream->start_time;
+    av_seek_frame(fmt_ctx, video_stream_idx, start, AVSEEK_FLAG_BACKWARD);
+    avcodec_flush_buffers(video_dec_ctx);
+    if(!anyKey)
+    {
+        keyframes.clear();
+        keyframes.remember(filename);
+        return;
+    }
+    keyframes.remember(filename);
+    if(!keyframes.save(keyframeName(), filename))
+        cerr<<"Could not write keyframe index "<<keyframeName()<<"\n";
+}
+
+void MyVideoReader::numberKeyframes()
+{
+    // frame numbers as reported by grabFrame, relative to the first frame
+    vector<int64_t> frames(keyframes.size(), -1);
+    for(unsigned long p = 0; p < keyframes.size(); p++)
+        if(keyframes.ptsOf(p) != AV_NOPTS_VALUE && first_frame_number >= 0)
+            frames[p] = dts_to_frame_number(keyframes.ptsOf(p)) - first_frame_number;
+    keyframes.setFrames(frames);
+}
+
 int MyVideoReader::open(string filen)
 {
-    src_filename=filen.c_str();
+    stopAhead();
+    draining = false;
+    clearReorder();
+    cache.clear();
+    fromCache = false;
+    cacheTarget = false;
+    decodedNumber = -1;
+    skipBefore = 0;
+    filename=filen;
+    src_filename=filename.c_str();
     int ret;
     isReady=1;
     if (avformat_open_input(&fmt_ctx, filen.c_str(), NULL, NULL) < 0) {
@@ -358,13 +698,6 @@ int MyVideoReader::open(string filen)
         width = video_dec_ctx->width;
         height = video_dec_ctx->height;
         pix_fmt = video_dec_ctx->pix_fmt;
-        ret = av_image_alloc(video_dst_data, video_dst_linesize,
-                             width, height, pix_fmt, 1);
-        if (ret < 0) {
-            fprintf(stderr, "Could not allocate raw video buffer\n");
-            isReady=0;
-        }
-        video_dst_bufsize = ret;
     }
     av_dump_format(fmt_ctx, 0, src_filename, 0);
     if (!audio_stream && !video_stream) {
@@ -380,18 +713,26 @@ int MyVideoReader::open(string filen)
     av_init_packet(&pkt);
     pkt.data = NULL;
     pkt.size = 0;
+    if(isReady)
+        indexKeyframes();
     grabFrame();
     grabFrame();
+    numberKeyframes();
     return isReady;
 }
 
 int MyVideoReader::release()
 {
+    stopAhead();
+    clearReorder();
+    freeFrames();
     if(video_dec_ctx)
         avcodec_free_context(&video_dec_ctx);
     avformat_close_input(&fmt_ctx);
     av_frame_free(&frame);
-    av_free(video_dst_data[0]);
+    keyframes.clear();
+    cache.clear();
+    fromCache = false;
     isReady=0;
     return 0;
 }
@@ -27,7 +27,13 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "Image.hpp"
+#include "KeyframeIndex.hpp"
+#include "FrameCache.hpp"
 //libav:
 extern "C" {
 #include <libavutil/channel_layout.h>
@@ -44,6 +50,14 @@ extern "C" {
 }
 #undef main
 
+// decoder threads, 0 lets FFmpeg use one per core
+#define VIDEODECODETHREADS 0
+#define VIDEODECODETHREADTYPE (FF_THREAD_FRAME|FF_THREAD_SLICE)
+// frames decoded ahead of the reader, 0 decodes on demand
+#define VIDEODECODEAHEAD 8
+// memory for the frames decoded around seeks (scrubbing), 0 keeps none
+#define VIDEOFRAMECACHEMB 256
+
 using namespace std;
 
 template < typename T > class Image;
@@ -72,24 +86,54 @@ public:
     int open(string filen);
     int release();
     int isOpened();
+    string keyframeName();
+    void setDecoding(int threads, int type, int ahead);
+    int getDecodeThreads(){return decodeThreads;};
+    int getDecodeThreadType(){return decodeThreadType;};
+    int getDecodeAhead(){return aheadDepth;};
+    void setFrameCache(unsigned long MB){cache.setBudget(MB);};
+    unsigned long getFrameCache(){return cache.getBudget();};
+    void setPreview(int lowres){previewLowres=lowres;};
+    int getPreview(){return previewLowres;};
 
 private:
+    // a reference to a frame of the decoder, its planes are not copied
+    struct DecodedFrame
+    {
+        AVFrame* pic;
+        int64_t pts;
+        int64_t number;
+    };
+    bool decodeFrame(DecodedFrame& f);
+    bool decodeWanted(DecodedFrame& f);
+    void clearReorder();
+    bool nextDecoded(DecodedFrame& f);
+    AVFrame* takeFrame();
+    void releaseFrame(AVFrame* p);
+    void freeFrames();
+    void aheadLoop();
+    void startAhead();
+    void stopAhead();
+    void indexKeyframes();
+    void numberKeyframes();
+    void seekDecoder(int64_t _frame_number);
+    bool seekToKeyframe(int64_t _frame_number);
+    void seekByGuess(int64_t _frame_number);
     int open_codec_context(int *stream_idx,
         AVCodecContext **dec_ctx, AVFormatContext *fmt_ctx, enum AVMediaType type);
-    int decode_packet(int *got_frame, int cached);
+    int decode_packet(AVPacket* p, bool keep);
     AVFormatContext *fmt_ctx;
     AVCodecContext *video_dec_ctx, *audio_dec_ctx;
     int width, height;
     enum AVPixelFormat pix_fmt;
     AVStream *video_stream, *audio_stream;
+    string filename;
     const char *src_filename;
+    KeyframeIndex keyframes;
     const char *video_dst_filename;
     const char *audio_dst_filename;
     FILE *video_dst_file;
     FILE *audio_dst_file;
-    uint8_t *video_dst_data[4];
-    int video_dst_linesize[4];
-    int video_dst_bufsize;
     int video_stream_idx, audio_stream_idx;
     AVFrame *frame;
     AVPacket pkt;
@@ -97,8 +141,37 @@ private:
     int audio_frame_count;
     int refcount;
     int64_t first_frame_number,frame_number,picture_pts;
-    int ret, got_frame;
+    // stream of the packet read last by grabFrame, -1 at the end of the file
+    int grabbedStream;
+    int ret;
     double eps_zero;
     int isReady;
+    int decodeThreads;
+    int decodeThreadType;
+    // reduced resolution (1<<lowres) without loop filter, -1 decodes full frames
+    int previewLowres;
+    bool draining;
+    // decoded frames not yet handed out, in decoding order
+    vector<DecodedFrame> reorder;
+    // unreferenced AVFrames for reuse, guarded by aheadMutex
+    vector<AVFrame*> spare;
+    int64_t decodedNumber;
+    int64_t skipBefore;
+    // decoded frames waiting for getNext, filled by aheadThread
+    thread aheadThread;
+    mutex aheadMutex;
+    condition_variable aheadCond;
+    deque<DecodedFrame> ahead;
+    int aheadDepth;
+    // frames decoded around the last seeks, getNext reads from it after a hit in seek
+    FrameCache cache;
+    bool fromCache;
+    int64_t cacheNext;
+    bool keepGrabbed;
+    // the next frame handed out is the target of a seek and goes into the cache
+    bool cacheTarget;
+    bool aheadRunning;
+    bool aheadStop;
+    bool aheadEnd;
 };
 #endif
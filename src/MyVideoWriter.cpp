@@ -26,6 +26,12 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "Image.hpp"
 #include "Metadata.hpp"
 #if CV_MAJOR_VERSION < 3
@@ -66,6 +72,12 @@ MyVideoWriter::MyVideoWriter(string filen,Settings is)
  isReady=1;
  next_pts=0;
  haveTmp=0;
+ sws_ctx=NULL;
+ colour_ctx=NULL;
+ tmp_frame=NULL;
+ encodeRunning=false;
+ encodeStop=false;
+ encodeErrors=0;
  av_register_all();
  fmt=av_guess_format(NULL, filen.c_str(), NULL);
  if(!fmt)
@@ -93,121 +105,47 @@ MyVideoWriter::MyVideoWriter(string filen,Settings is)
   snprintf(oc->filename, sizeof(oc->filename), "%s", filen.c_str());
   if(fmt->video_codec!=AV_CODEC_ID_NONE)
   {
-   if(settings.by_name)
+   st=avformat_new_stream(oc, NULL);
+   if(!st)
    {
-    codec=avcodec_find_encoder_by_name(settings.codec_by_name.c_str());
-    if (!codec) 
-    {
-     fprintf(stderr, "%s codec not found\n", settings.codec_by_name);
-     isReady=0; 
-    }
-   }
-   else
-   {
-    codec=avcodec_find_encoder(settings.video_codec);
-    if(!codec)
-    {
-     fprintf(stderr, "%d codec not found\n",settings.video_codec);
-     isReady=0;
-    }
-   }    
-   if(isReady)
-   {
-    st=avformat_new_stream(oc, NULL);
-    if(!st)
-    {
-     fprintf(stderr, "Could not alloc stream\n");
-     isReady=0;
-    }
-   }
-   if(isReady)
-   {
-    enc=avcodec_alloc_context3(codec);
-    if (!enc)
-    {
-     fprintf(stderr, "Could not alloc an encoding context\n");
-     isReady=0;
-    }
-   }
-   if(isReady)
-   {
-    if(!settings.useCrf)
-     enc->bit_rate=settings.bit_rate;
-    else
-     enc->bit_rate=0;
-    enc->width=settings.w;
-    enc->height=settings.h;
-    st->time_base=(AVRational){ settings.timebasenum, settings.timebaseden };
-    enc->time_base=st->time_base;
-    enc->gop_size=settings.gop_size;
-    enc->pix_fmt=AV_PIX_FMT_YUV420P;
-    enc->max_b_frames=0;
-    enc->qmin=0;
-    enc->qmax=51;
-    if(oc->oformat->flags&AVFMT_GLOBALHEADER)
-     enc->flags|=AV_CODEC_FLAG_GLOBAL_HEADER;
-    if(codec->id==AV_CODEC_ID_H264)
-    {
-     if(settings.useCrf)
-     {
-      if(settings.by_name)
-      {
-       av_opt_set(enc->priv_data, "preset", "hq", 0);
-       av_opt_set(enc->priv_data, "profil", "high", 0);
-       av_opt_set(enc->priv_data, "cq",  std::to_string(settings.crf).c_str(), 0);
-      }
-      else
-      {
-       av_opt_set(enc->priv_data, "crf",  std::to_string(settings.crf).c_str(), 0);
-       av_opt_set(enc->priv_data, "preset", settings.preset.c_str(), 0);
-      }
-     }
-    }
-    else if(codec->id==AV_CODEC_ID_HEVC)
-    {
-     if(settings.useCrf)
-     {
-      if(settings.by_name)
-      {
-       av_opt_set(enc->priv_data, "preset", "hq", 0);
-       av_opt_set(enc->priv_data, "cq",  std::to_string(settings.crf).c_str(), 0);
-      }
-      else
-      {
-       av_opt_set(enc->priv_data, "preset", settings.preset.c_str(), 0);
-       av_opt_set(enc->priv_data, "tune", "zerolatency", 0);
-       av_opt_set(enc->priv_data, "crf",  std::to_string(settings.crf).c_str(), 0);
-      }
-     }
-    }
-    else
-    {
-     if(settings.useCrf)
-      fprintf(stderr, "Error: I don't know the codec id and can't set crf\n");    
-    }
+    fprintf(stderr, "Could not alloc stream\n");
+    isReady=0;
    }
   }
+  else
+  {
+   fprintf(stderr, "Output format has no video\n");
+   isReady=0;
+  }
  }
  if(isReady)
  {
-  if(avcodec_open2(enc, NULL, NULL) < 0) 
+  // the first encoder which opens is used, so a missing GPU only costs one try
+  enc=NULL;
+  vector<AVCodec*> candidates=encoderCandidates();
+  for(unsigned long i=0; i<candidates.size() && !enc; i++)
+   openEncoder(candidates[i]);
+  if(!enc)
   {
    fprintf(stderr, "could not open codec\n");
    isReady=0;
   }
+  else
+   fprintf(stderr, "Encoding with %s\n", codec->name);
  }
  if(isReady)
  {
-  frame=alloc_picture(enc->pix_fmt, enc->width, enc->height);
+  AVFrame* frame=alloc_picture(enc->pix_fmt, enc->width, enc->height);
   if(!frame)
   {
    fprintf(stderr, "Could not allocate picture\n");
    isReady=0;
   }
+  else
+   spare.push_back(frame);
  }
  if(isReady)
  {
-  tmp_frame=NULL;
   if(enc->pix_fmt!=AV_PIX_FMT_YUV420P)
   {
    tmp_frame=alloc_picture(AV_PIX_FMT_YUV420P, enc->width, enc->height);
@@ -246,20 +184,105 @@ MyVideoWriter::MyVideoWriter(string filen,Settings is)
  }
 }
 
-MyVideoWriter::~MyVideoWriter()
+vector<AVCodec*> MyVideoWriter::encoderCandidates()
 {
- if(isReady) getLateFrames();    
- if(isReady) av_write_trailer(oc);
- if(isReady) avcodec_free_context(&enc);
- if(isReady) av_frame_free(&frame);
- if(haveTmp)
+ // a named encoder first, then the CPU encoders from the fastest good one down to mpeg4
+ vector<AVCodec*> c;
+ vector<string> names;
+ if(settings.by_name && !settings.codec_by_name.empty())
+  names.push_back(settings.codec_by_name);
+ if(settings.video_codec==AV_CODEC_ID_HEVC)
+  names.push_back("libx265");
+ names.push_back("libx264");
+ for(unsigned long i=0; i<names.size(); i++)
  {
-  av_frame_free(&tmp_frame);
-  sws_freeContext(sws_ctx);
+  AVCodec* e=avcodec_find_encoder_by_name(names[i].c_str());
+  if(e)
+   c.push_back(e);
+  else
+   fprintf(stderr, "%s codec not found\n", names[i].c_str());
  }
- if(isReady && !(fmt->flags & AVFMT_NOFILE))
-  avio_close(oc->pb);
- if(isReady) avformat_free_context(oc);
+ AVCodecID ids[3]={settings.video_codec, AV_CODEC_ID_H264, AV_CODEC_ID_MPEG4};
+ for(int i=0; i<3; i++)
+ {
+  AVCodec* e=avcodec_find_encoder(ids[i]);
+  if(e && find(c.begin(), c.end(), e)==c.end())
+   c.push_back(e);
+ }
+ return c;
+}
+
+bool MyVideoWriter::openEncoder(AVCodec* c)
+{
+ enc=avcodec_alloc_context3(c);
+ if(!enc)
+ {
+  fprintf(stderr, "Could not alloc an encoding context\n");
+  return false;
+ }
+ string name=c->name;
+ bool nvenc=name.find("nvenc")!=string::npos;
+ bool x26x=name=="libx264" || name=="libx265";
+ if(!settings.useCrf || !(nvenc || x26x))
+  enc->bit_rate=settings.bit_rate;
+ else
+  enc->bit_rate=0;
+ enc->width=settings.w;
+ enc->height=settings.h;
+ st->time_base=(AVRational){ settings.timebasenum, settings.timebaseden };
+ enc->time_base=st->time_base;
+ enc->gop_size=settings.gop_size;
+ enc->pix_fmt=AV_PIX_FMT_YUV420P;
+ enc->max_b_frames=0;
+ if(c->id==AV_CODEC_ID_H264 || c->id==AV_CODEC_ID_HEVC)
+ {
+  enc->qmin=0;
+  enc->qmax=51;
+ }
+ else
+ {
+  enc->qmin=2;
+  enc->qmax=31;
+ }
+ enc->thread_count=settings.threads<0?0:settings.threads;
+ if(oc->oformat->flags&AVFMT_GLOBALHEADER)
+  enc->flags|=AV_CODEC_FLAG_GLOBAL_HEADER;
+ if(nvenc)
+ {
+  if(settings.useCrf)
+  {
+   av_opt_set(enc->priv_data, "preset", "hq", 0);
+   if(c->id==AV_CODEC_ID_H264)
+    av_opt_set(enc->priv_data, "profile", "high", 0);
+   av_opt_set(enc->priv_data, "cq",  std::to_string(settings.crf).c_str(), 0);
+  }
+ }
+ else if(x26x)
+ {
+  av_opt_set(enc->priv_data, "preset", settings.preset.c_str(), 0);
+  if(settings.useCrf)
+  {
+   if(c->id==AV_CODEC_ID_HEVC)
+    av_opt_set(enc->priv_data, "tune", "zerolatency", 0);
+   av_opt_set(enc->priv_data, "crf",  std::to_string(settings.crf).c_str(), 0);
+  }
+ }
+ else if(settings.useCrf)
+  fprintf(stderr, "Error: %s has no crf, using the bitrate\n", c->name);
+ if(avcodec_open2(enc, c, NULL) < 0)
+ {
+  fprintf(stderr, "could not open %s\n", c->name);
+  avcodec_free_context(&enc);
+  enc=NULL;
+  return false;
+ }
+ codec=c;
+ return true;
+}
+
+MyVideoWriter::~MyVideoWriter()
+{
+ close();
 }
 
 AVFrame *MyVideoWriter::alloc_picture(enum AVPixelFormat pix_fmt, int width, int height)
@@ -280,207 +303,128 @@ AVFrame *MyVideoWriter::alloc_picture(enum AVPixelFormat pix_fmt, int width, int
  return picture;
 }
 
-int MyVideoWriter::add(Image<unsigned char>* img)
+bool MyVideoWriter::fill(AVFrame* f, const unsigned char* src, int stride, int w, int h, int channels)
 {
- int ret;
- if(isReady)
+ // whole rows are copied or converted at once, never single pixels
+ if(channels==1 && (!src || (w==enc->width && h==enc->height)))
  {
-  if(enc->pix_fmt !=AV_PIX_FMT_YUV420P)
+  // grey values are the luma plane as they are, chroma stays neutral;
+  // without an image the frame is black
+  AVFrame* yuv=enc->pix_fmt==AV_PIX_FMT_YUV420P?f:tmp_frame;
+  if(yuv==tmp_frame && av_frame_make_writable(tmp_frame)<0)
+   return false;
+  for(int y=0; y<enc->height; y++)
   {
-   if(!sws_ctx)
-   {
-    sws_ctx=sws_getContext(enc->width, enc->height, AV_PIX_FMT_YUV420P,
-                             enc->width, enc->height, enc->pix_fmt,
-                             SWS_BICUBIC, NULL, NULL, NULL);
-    if(!sws_ctx)
-     fprintf(stderr,"Cannot initialize the conversion context\n");
-   }
-   ret=av_frame_make_writable(tmp_frame);
-   for(int y=0; y<enc->height; y++)
-    for(int x=0; x<enc->width; x++)
-     tmp_frame->data[0][y*tmp_frame->linesize[0]+x]=img->getValue(x,y);
-   for(int y=0; y<enc->height/2; y++)
-    for(int x=0; x<enc->width/2; x++)
-   {
-    tmp_frame->data[1][y*tmp_frame->linesize[1]+x]=128;
-    tmp_frame->data[2][y*tmp_frame->linesize[2]+x]=128;
-   }
-   sws_scale(sws_ctx, tmp_frame->data, tmp_frame->linesize,
-             0, enc->height, frame->data, frame->linesize);
-  }
-  else
-  {
-   ret=av_frame_make_writable(frame);
-   for(int y=0; y<enc->height; y++)
-    for(int x=0; x<enc->width; x++)
-     frame->data[0][y*frame->linesize[0]+x]=img->getValue(x,y);
-   for(int y=0; y<enc->height/2; y++)
-   {
-    for(int x=0; x<enc->width/2; x++)
-    {
-     frame->data[1][y*frame->linesize[1]+x]=128;
-     frame->data[2][y*frame->linesize[2]+x]=128;
-    }
-   }
+   unsigned char* dst=yuv->data[0]+(size_t)y*yuv->linesize[0];
+   if(src)
+    memcpy(dst, src+(size_t)y*stride, enc->width);
+   else
+    memset(dst, 0, enc->width);
   }
-  frame->pts=++next_pts;
-  ret=avcodec_send_frame(enc, frame);
-  if(ret<0)
+  for(int y=0; y<(enc->height+1)/2; y++)
   {
-   fprintf(stderr, "Error submitting a frame for encoding\n");
+   memset(yuv->data[1]+(size_t)y*yuv->linesize[1], 128, (enc->width+1)/2);
+   memset(yuv->data[2]+(size_t)y*yuv->linesize[2], 128, (enc->width+1)/2);
   }
-  while(ret>=0)
+  if(yuv==tmp_frame)
   {
-   AVPacket pkt={0};
-   av_init_packet(&pkt);
-   ret=avcodec_receive_packet(enc,&pkt);
-   if(ret<0 && ret!=AVERROR(EAGAIN) && ret!=AVERROR_EOF)
-   {
-    fprintf(stderr, "Error encoding a video frame\n");
-   } 
-   else if(ret>=0)
+   sws_ctx=sws_getCachedContext(sws_ctx, enc->width, enc->height, AV_PIX_FMT_YUV420P,
+                                enc->width, enc->height, enc->pix_fmt,
+                                SWS_BICUBIC, NULL, NULL, NULL);
+   if(!sws_ctx)
    {
-    av_packet_rescale_ts(&pkt, enc->time_base, st->time_base);
-    pkt.stream_index=st->index;
-    ret=av_interleaved_write_frame(oc, &pkt);
-    if(ret<0)
-     fprintf(stderr, "Error while writing video frame\n");
+    fprintf(stderr,"Cannot initialize the conversion context\n");
+    return false;
    }
+   sws_scale(sws_ctx, tmp_frame->data, tmp_frame->linesize,
+             0, enc->height, f->data, f->linesize);
   }
-  addedImages++;
-  return ret>=0;
+  return true;
  }
- else
+ if(channels==1 || channels==3 || channels==4)
+ {
+  // grey images of another size and all colour images are scaled and converted in one go
+  if(!src || w<=0 || h<=0)
+   return false;
+  AVPixelFormat fmt=channels==1?AV_PIX_FMT_GRAY8:(channels==3?AV_PIX_FMT_BGR24:AV_PIX_FMT_BGRA);
+  colour_ctx=sws_getCachedContext(colour_ctx, w, h, fmt,
+                                  enc->width, enc->height, enc->pix_fmt,
+                                  SWS_BILINEAR, NULL, NULL, NULL);
+  if(!colour_ctx)
+  {
+   fprintf(stderr,"Cannot initialize the conversion context\n");
+   return false;
+  }
+  const uint8_t* srcSlice[4]={src, NULL, NULL, NULL};
+  int srcStride[4]={stride, 0, 0, 0};
+  sws_scale(colour_ctx, srcSlice, srcStride, 0, h, f->data, f->linesize);
+  return true;
+ }
+ fprintf(stderr, "Error: Cannot encode images with %d channels\n", channels);
+ return false;
+}
+
+int MyVideoWriter::add(Image<unsigned char>* img)
+{
+ if(!isReady)
+  return -1;
+ AVFrame* frame=takeFrame();
+ if(!frame)
   return -1;
+ bool ok=img->hasBuffer()?fill(frame, img->buffer, img->getX(), img->getX(), img->getY(), 1)
+                         :fill(frame, NULL, 0, 0, 0, 1);
+ if(!ok)
+ {
+  lock_guard<mutex> lock(encodeMutex);
+  spare.push_back(frame);
+  return 0;
+ }
+ frame->pts=++next_pts;
+ addedImages++;
+ return submit(frame);
 }
 
 int MyVideoWriter::add(Mat& img)
 {
- int channels=img.channels();
- int ret;
- if(isReady)
+ if(!isReady)
+  return -1;
+ if(img.depth()!=CV_8U)
  {
-  if(enc->pix_fmt!=AV_PIX_FMT_YUV420P)
-  {
-   if(!sws_ctx)
-   {
-    sws_ctx=sws_getContext(enc->width, enc->height, AV_PIX_FMT_YUV420P,
-                           enc->width, enc->height, enc->pix_fmt,
-                           SWS_BICUBIC, NULL, NULL, NULL);
-    if(!sws_ctx)
-     fprintf(stderr,"Cannot initialize the conversion context\n");
-   }
-   ret=av_frame_make_writable(tmp_frame);
-   if(channels==1)
-   {
-    for(int y=0; y<enc->height; y++)
-     for(int x=0; x<enc->width; x++)
-      tmp_frame->data[0][y*tmp_frame->linesize[0]+x]=img.at<unsigned char>(y,x);
-    for (int y=0; y<enc->height/2; y++)
-     for (int x=0; x<enc->width/2; x++)
-    {
-     tmp_frame->data[1][y*tmp_frame->linesize[1]+x]=128;
-     tmp_frame->data[2][y*tmp_frame->linesize[2]+x]=128;
-    }
-   }
-   else
-   {
-    for(int y=0; y<enc->height; y++)
-     for (int x=0; x<enc->width; x++)
-    {
-     Vec3b colour=img.at<Vec3b>(y,x);
-     tmp_frame->data[0][y*tmp_frame->linesize[0]+x]=((66*colour.val[2]+129*colour.val[1]+25*colour.val[0])>>8)+16;
-    }    
-    for(int y=0; y<enc->height/2; y++)
-     for(int x=0; x<enc->width/2; x++)
-    {
-     Vec3b colour=img.at<Vec3b>(2*y,2*x);
-     tmp_frame->data[1][y*tmp_frame->linesize[1]+x]=((-38*colour.val[2]-74*colour.val[1]+112*colour.val[0])>>8)+128;
-     tmp_frame->data[2][y*tmp_frame->linesize[2]+x]=((112*colour.val[2]-94*colour.val[1]-18*colour.val[0])>>8)+128;
-    }
-   }
-   sws_scale(sws_ctx, tmp_frame->data, tmp_frame->linesize,
-             0, enc->height, frame->data, frame->linesize);
-  }
-  else
-  {
-   ret=av_frame_make_writable(frame);
-   if(channels==1)
-   {
-    for(int y=0; y<enc->height; y++)
-     for(int x=0; x<enc->width; x++)
-      frame->data[0][y*frame->linesize[0]+x]=img.at<unsigned char>(y,x);
-    for(int y=0; y<enc->height/2; y++)
-     for(int x=0; x<enc->width/2; x++)
-    {
-     frame->data[1][y*frame->linesize[1]+x]=128;
-     frame->data[2][y*frame->linesize[2]+x]=128;
-    }
-   }
-   else
-   {
-    for(int y=0; y<enc->height; y++)
-     for (int x=0; x < enc->width; x++)
-    {
-     Vec3b colour=img.at<Vec3b>(y,x);
-     frame->data[0][y*frame->linesize[0]+x]=((66*colour.val[2]+129*colour.val[1]+25*colour.val[0])>>8)+16;
-    }
-    for(int y=0; y<enc->height/2; y++)
-     for (int x=0; x < enc->width / 2; x++)
-    {
-     Vec3b colour=img.at<Vec3b>(2*y,2*x);
-     frame->data[1][y*frame->linesize[1]+x]=((-38*colour.val[2]-74*colour.val[1]+112*colour.val[0])>>8)+128;
-     frame->data[2][y*frame->linesize[2]+x]=((112*colour.val[2]-94*colour.val[1]-18*colour.val[0])>>8)+128;
-    }
-   }
-  }
-  frame->pts=++next_pts;
-  ret=avcodec_send_frame(enc, frame);
-  if(ret<0)
-   fprintf(stderr, "Error submitting a frame for encoding\n");
-  while(ret>=0)
-  {
-   AVPacket pkt={0};
-   av_init_packet(&pkt);
-   ret=avcodec_receive_packet(enc, &pkt);
-   if(ret<0 && ret!=AVERROR(EAGAIN) && ret!=AVERROR_EOF)
-   {
-    fprintf(stderr, "Error encoding a video frame\n");
-   }
-   else if(ret>=0)
-   {
-    av_packet_rescale_ts(&pkt, enc->time_base, st->time_base);
-    pkt.stream_index=st->index;
-    ret=av_interleaved_write_frame(oc, &pkt);
-    if(ret<0)
-     fprintf(stderr, "Error while writing video frame\n");
-   }
-  }
-  addedImages++;
-  return ret==AVERROR_EOF;
+  fprintf(stderr, "Error: Only images with 8 bit per channel can be encoded\n");
+  return 0;
  }
- else
+ AVFrame* frame=takeFrame();
+ if(!frame)
   return -1;
+ if(!fill(frame, img.data, (int)img.step, img.cols, img.rows, img.channels()))
+ {
+  lock_guard<mutex> lock(encodeMutex);
+  spare.push_back(frame);
+  return 0;
+ }
+ frame->pts=++next_pts;
+ addedImages++;
+ return submit(frame);
 }
 
-int MyVideoWriter::getLateFrames()
+int MyVideoWriter::encode(AVFrame* f)
 {
- int ret;
- frame=NULL;
- ret=avcodec_send_frame(enc, frame);
+ // sends f to the encoder and writes all packets it has ready, NULL drains it
+ int ret=avcodec_send_frame(enc, f);
  if(ret<0)
  {
   fprintf(stderr, "Error submitting a frame for encoding\n");
+  return ret;
  }
  while(ret>=0)
  {
   AVPacket pkt={0};
   av_init_packet(&pkt);
   ret=avcodec_receive_packet(enc,&pkt);
-  if(ret==AVERROR_EOF) cerr<<"got all buffer...\n";
   if(ret<0 && ret!=AVERROR(EAGAIN) && ret!=AVERROR_EOF)
   {
    fprintf(stderr, "Error encoding a video frame\n");
+   return ret;
   }
   else if(ret>=0)
   {
@@ -488,9 +432,105 @@ int MyVideoWriter::getLateFrames()
    pkt.stream_index=st->index;
    ret=av_interleaved_write_frame(oc, &pkt);
    if(ret<0)
+   {
     fprintf(stderr, "Error while writing video frame\n");
+    return ret;
+   }
+  }
+ }
+ return ret;
+}
+
+AVFrame* MyVideoWriter::takeFrame()
+{
+ // waits while the encoder is behind, so at most queue frames are pending
+ AVFrame* f=NULL;
+ {
+  unique_lock<mutex> lock(encodeMutex);
+  encodeCond.wait(lock, [this](){return (int)pending.size()<settings.queue || !encodeRunning;});
+  if(!spare.empty())
+  {
+   f=spare.back();
+   spare.pop_back();
   }
  }
+ if(!f)
+ {
+  f=alloc_picture(enc->pix_fmt, enc->width, enc->height);
+  if(!f)
+   fprintf(stderr, "Could not allocate picture\n");
+ }
+ else if(av_frame_make_writable(f)<0)
+ {
+  av_frame_free(&f);
+  fprintf(stderr, "Could not make picture writable\n");
+ }
+ return f;
+}
+
+int MyVideoWriter::submit(AVFrame* f)
+{
+ if(settings.queue<=0)
+ {
+  int ret=encode(f);
+  spare.push_back(f);
+  if(ret<0 && ret!=AVERROR(EAGAIN))
+   return 0;
+  return 1;
+ }
+ unique_lock<mutex> lock(encodeMutex);
+ if(!encodeRunning)
+ {
+  encodeStop=false;
+  encodeRunning=true;
+  encodeThread=thread(&MyVideoWriter::encodeLoop, this);
+ }
+ pending.push_back(f);
+ encodeCond.notify_all();
+ return encodeErrors==0;
+}
+
+void MyVideoWriter::encodeLoop()
+{
+ unique_lock<mutex> lock(encodeMutex);
+ while(true)
+ {
+  encodeCond.wait(lock, [this](){return !pending.empty() || encodeStop;});
+  if(pending.empty())
+   break;
+  AVFrame* f=pending.front();
+  lock.unlock();
+  int ret=encode(f);
+  lock.lock();
+  pending.pop_front();
+  spare.push_back(f);
+  if(ret<0 && ret!=AVERROR(EAGAIN))
+   encodeErrors++;
+  encodeCond.notify_all();
+ }
+}
+
+void MyVideoWriter::stopEncoder()
+{
+ // the encoder thread writes all pending frames before it stops
+ {
+  lock_guard<mutex> lock(encodeMutex);
+  if(!encodeRunning)
+   return;
+  encodeStop=true;
+ }
+ encodeCond.notify_all();
+ encodeThread.join();
+ lock_guard<mutex> lock(encodeMutex);
+ encodeRunning=false;
+ encodeStop=false;
+}
+
+int MyVideoWriter::getLateFrames()
+{
+ stopEncoder();
+ int ret=encode(NULL);
+ if(ret==AVERROR_EOF) cerr<<"got all buffer...\n";
  return ret==AVERROR_EOF;
 }
 
@@ -504,15 +544,20 @@ int MyVideoWriter::close()
  if(isReady) getLateFrames();    
  if(isReady) av_write_trailer(oc);
  if(isReady) avcodec_free_context(&enc);
- if(isReady) av_frame_free(&frame);
+ for(unsigned long i=0; i<spare.size(); i++)
+  av_frame_free(&spare[i]);
+ spare.clear();
  if(haveTmp)
- {
   av_frame_free(&tmp_frame);
-  sws_freeContext(sws_ctx);
- }
+ sws_freeContext(sws_ctx);
+ sws_ctx=NULL;
+ sws_freeContext(colour_ctx);
+ colour_ctx=NULL;
  if(isReady && !(fmt->flags&AVFMT_NOFILE))
   avio_close(oc->pb);
  if(isReady) avformat_free_context(oc);
+ isReady=0;
+ haveTmp=0;
  return 0;
 }
 
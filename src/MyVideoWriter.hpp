@@ -27,6 +27,10 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "Image.hpp"
 #include "Metadata.hpp"
 #if CV_MAJOR_VERSION < 3
@@ -55,8 +59,22 @@ extern "C" {
 }
 #undef main
 
+// encoder threads, 0 lets FFmpeg use one per core
+#define VIDEOENCODETHREADS 0
+// frames waiting for the encoder thread, 0 encodes on the caller's thread
+#define VIDEOENCODEQUEUE 8
+// speed preset of libx264 and libx265
+#define VIDEOENCODEPRESET "veryfast"
+
 using namespace std;
 
+/**
+  * \brief Class to write frames to a video file
+  *
+  * Frames are converted on the caller's thread and encoded on an encoder
+  * thread. add() waits while the queue of the encoder is full, close()
+  * writes all queued frames.
+  */
 class MyVideoWriter
 {
 public:
@@ -67,12 +85,16 @@ public:
         int timebasenum=1;
         int timebaseden=25;
         int gop_size=60;
-        AVCodecID video_codec=AV_CODEC_ID_H265;
-        string codec_by_name="h264_nvenc";
-        int by_name=1;
-        string preset="slow";
+        AVCodecID video_codec=AV_CODEC_ID_H264;
+        // an encoder tried before the CPU encoders, e.g. h264_nvenc
+        string codec_by_name="";
+        int by_name=0;
+        // x264/x265 preset, ultrafast ... veryslow
+        string preset=VIDEOENCODEPRESET;
         int crf=0;
         bool useCrf=false;
+        int threads=VIDEOENCODETHREADS;
+        int queue=VIDEOENCODEQUEUE;
     };
     MyVideoWriter(string filen,Settings is);
     ~MyVideoWriter();
@@ -91,14 +113,23 @@ private:
     int openMeta();
     Settings settings;
     AVFrame *alloc_picture(enum AVPixelFormat pix_fmt, int width, int height);
+    vector<AVCodec*> encoderCandidates();
+    bool openEncoder(AVCodec* c);
     int getLateFrames();
+    bool fill(AVFrame* f, const unsigned char* src, int stride, int w, int h, int channels);
+    int encode(AVFrame* f);
+    AVFrame* takeFrame();
+    int submit(AVFrame* f);
+    void encodeLoop();
+    void stopEncoder();
     AVStream *st;
     AVCodecContext *enc;
     int64_t next_pts;
-    AVFrame *frame;
     AVFrame *tmp_frame;
     float t, tincr, tincr2;
+    // YUV420P to the encoder's format, and grey of another size or BGR(A) to it
     struct SwsContext *sws_ctx;
+    struct SwsContext *colour_ctx;
     AVCodec *codec;
     const char *filename;
     AVOutputFormat *fmt;
@@ -109,5 +140,14 @@ private:
     int have_meta;
     string vidfilename;
     unsigned int addedImages;
+    // converted frames waiting for encodeThread, and encoded ones for reuse
+    thread encodeThread;
+    mutex encodeMutex;
+    condition_variable encodeCond;
+    deque<AVFrame*> pending;
+    vector<AVFrame*> spare;
+    bool encodeRunning;
+    bool encodeStop;
+    int encodeErrors;
 };
 #endif
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "PositionBackup.hpp"
+#include "BinaryIO.hpp"
+#include "Sidecar.hpp"
+#include <iostream>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+PositionBackup::PositionBackup()
+{
+    file=nullptr;
+    syncEvery=POSITIONBACKUPSYNCFRAMES;
+    unsynced=0;
+}
+
+PositionBackup::~PositionBackup()
+{
+    close();
+}
+
+bool PositionBackup::open(string filename, int syncFrames /* = POSITIONBACKUPSYNCFRAMES */)
+{
+    close();
+    name=filename;
+    syncEvery=syncFrames>0?syncFrames:1;
+    unsynced=0;
+    FILE* test=fopen(filename.c_str(),"rb");
+    if(test)
+    {
+     fclose(test);
+     if(!isBackupFile(filename))
+     {
+      cerr<<"Backup file "<<filename<<" is not a binary position backup, I won't append to it\n";
+      return false;
+     }
+     // continue behind the last good record
+     long validBytes=0;
+     scan(filename, &validBytes);
+     file=fopen(filename.c_str(),"r+b");
+     if(!file)
+     {
+      cerr<<"Failed to open Backup File for writing\n";
+      return false;
+     }
+     fseek(file, 0, SEEK_END);
+     if(ftell(file)>validBytes)
+     {
+      cerr<<"Cutting off "<<ftell(file)-validBytes<<" corrupt bytes at the end of "<<filename<<"\n";
+      fflush(file);
+#ifdef _WIN32
+      _chsize(_fileno(file), validBytes);
+#else
+      if(ftruncate(fileno(file), validBytes)!=0)
+       cerr<<"Failed to truncate "<<filename<<"\n";
+#endif
+     }
+     fseek(file, validBytes, SEEK_SET);
+    }
+    else
+    {
+     file=fopen(filename.c_str(),"wb");
+     if(!file)
+     {
+      cerr<<"Failed to open Backup File for writing\n";
+      return false;
+     }
+     uint32_t head[2]={POSITIONBACKUPMAGIC, POSITIONBACKUPVERSION};
+     fwrite(head, sizeof(uint32_t), 2, file);
+     sync();
+    }
+    return true;
+}
+
+bool PositionBackup::append(MosquitoesInFrame* frame)
+{
+    if(!file)
+     return false;
+    buffer.clear();
+    putBinary<uint32_t>(buffer, 0);
+    putBinary<uint32_t>(buffer, 0);
+    encode(frame, buffer);
+    uint32_t n=buffer.size()-2*sizeof(uint32_t);
+    uint32_t crc=Sidecar::crc32(buffer.data()+2*sizeof(uint32_t), n);
+    memcpy(buffer.data(), &n, sizeof(uint32_t));
+    memcpy(buffer.data()+sizeof(uint32_t), &crc, sizeof(uint32_t));
+    if(fwrite(buffer.data(), 1, buffer.size(), file)!=buffer.size())
+    {
+     cerr<<"Error writing to backup file "<<name<<"\n";
+     return false;
+    }
+    unsynced++;
+    if(unsynced>=syncEvery)
+     return sync();
+    return true;
+}
+
+bool PositionBackup::sync()
+{
+    if(!file)
+     return false;
+    unsynced=0;
+    if(fflush(file)!=0)
+     return false;
+#ifdef _WIN32
+    return _commit(_fileno(file))==0;
+#else
+    return fsync(fileno(file))==0;
+#endif
+}
+
+void PositionBackup::close()
+{
+    if(file)
+    {
+     sync();
+     fclose(file);
+     file=nullptr;
+    }
+}
+
+bool PositionBackup::isBackupFile(string filename)
+{
+    FILE* f=fopen(filename.c_str(),"rb");
+    if(!f)
+     return false;
+    uint32_t head[2]={0,0};
+    size_t n=fread(head, sizeof(uint32_t), 2, f);
+    fclose(f);
+    return n==2 && head[0]==POSITIONBACKUPMAGIC && head[1]==POSITIONBACKUPVERSION;
+}
+
+long PositionBackup::scan(string filename, long* validBytes /* = nullptr */)
+{
+    // like read(), but the payloads are only checked against their CRC and
+    // not decoded; returns the number of the last frame stored in a good record, or -1
+    long last=-1;
+    if(validBytes) *validBytes=0;
+    FILE* f=fopen(filename.c_str(),"rb");
+    if(!f)
+     return last;
+    uint32_t head[2]={0,0};
+    if(fread(head, sizeof(uint32_t), 2, f)!=2 || head[0]!=POSITIONBACKUPMAGIC || head[1]!=POSITIONBACKUPVERSION)
+    {
+     fclose(f);
+     return last;
+    }
+    long good=2*sizeof(uint32_t);
+    vector<char> payload;
+    uint32_t rec[2];
+    while(fread(rec, sizeof(uint32_t), 2, f)==2)
+    {
+     if(rec[0]>POSITIONBACKUPMAXRECORD || rec[0]<sizeof(uint64_t))
+      break;
+     payload.resize(rec[0]);
+     if(fread(payload.data(), 1, rec[0], f)!=rec[0])
+      break;
+     if(Sidecar::crc32(payload.data(), rec[0])!=rec[1])
+      break;
+     // the frame number leads the payload
+     const char* p=payload.data();
+     uint64_t frameNo;
+     getBinary(p,p+rec[0],frameNo);
+     last=frameNo;
+     good+=2*sizeof(uint32_t)+rec[0];
+    }
+    fclose(f);
+    if(validBytes) *validBytes=good;
+    return last;
+}
+
+long PositionBackup::read(string filename, vector<MosquitoesInFrame>& frames)
+{
+    // returns the number of the last frame stored in a good record, or -1
+    long last=-1;
+    FILE* f=fopen(filename.c_str(),"rb");
+    if(!f)
+     return last;
+    uint32_t head[2]={0,0};
+    if(fread(head, sizeof(uint32_t), 2, f)!=2 || head[0]!=POSITIONBACKUPMAGIC || head[1]!=POSITIONBACKUPVERSION)
+    {
+     fclose(f);
+     return last;
+    }
+    vector<char> payload;
+    uint32_t rec[2];
+    while(fread(rec, sizeof(uint32_t), 2, f)==2)
+    {
+     if(rec[0]>POSITIONBACKUPMAXRECORD)
+      break;
+     payload.resize(rec[0]);
+     if(rec[0]>0 && fread(payload.data(), 1, rec[0], f)!=rec[0])
+      break;
+     if(Sidecar::crc32(payload.data(), rec[0])!=rec[1])
+      break;
+     MosquitoesInFrame frame;
+     if(!decode(payload.data(), rec[0], frame))
+      break;
+     last=frame.getFrameNo();
+     frames.push_back(frame);
+    }
+    fclose(f);
+    return last;
+}
+
+void PositionBackup::encode(MosquitoesInFrame* frame, vector<char>& b)
+{
+    putBinary<uint64_t>(b, frame->getFrameNo());
+    putBinary<int32_t>(b, frame->getTsSec());
+    putBinary<uint16_t>(b, frame->getTsMSec());
+    putBinary<uint16_t>(b, frame->getTsUSec());
+    putBinary<double>(b, frame->getMaxDiff());
+    putBinary<int32_t>(b, frame->getProcessed());
+    putBinary<uint32_t>(b, frame->numOfMosquitoes());
+    for(int j=0; j<frame->numOfMosquitoes(); j++)
+    {
+     MosquitoPosition* m=frame->mosqi(j);
+     putBinary<double>(b, m->getX());
+     putBinary<double>(b, m->getY());
+     putBinary<double>(b, m->getA());
+     putBinary<double>(b, m->getI());
+     putBinary<double>(b, m->getCircularity());
+     putBinary<double>(b, m->getInertia());
+     putBinary<double>(b, m->getConvexity());
+     putBinary<int32_t>(b, m->getFlag());
+     vector<cv::Point> c;
+     if(m->MosquitoHasContour())
+      c=m->getContour();
+     putBinary<uint32_t>(b, c.size());
+     for(unsigned long k=0; k<c.size(); k++)
+     {
+      putBinary<int32_t>(b, c[k].x);
+      putBinary<int32_t>(b, c[k].y);
+     }
+    }
+}
+
+bool PositionBackup::decode(const char* data, size_t n, MosquitoesInFrame& frame)
+{
+    const char* p=data;
+    const char* end=data+n;
+    uint64_t frameNo;
+    int32_t sec;
+    uint16_t msec;
+    uint16_t usec;
+    double maxDiff;
+    int32_t processed;
+    uint32_t num;
+    if(!(getBinary(p,end,frameNo) && getBinary(p,end,sec) && getBinary(p,end,msec) && getBinary(p,end,usec) &&
+         getBinary(p,end,maxDiff) && getBinary(p,end,processed) && getBinary(p,end,num)))
+     return false;
+    frame.setFrameNo(frameNo);
+    frame.setTsSec(sec);
+    frame.setTsMSec(msec);
+    frame.setTsUSec(usec);
+    frame.setMaxDiff(maxDiff);
+    frame.setProcessed(processed);
+    for(uint32_t j=0; j<num; j++)
+    {
+     double x,y,a,i,circularity,inertia,convexity;
+     int32_t flag;
+     uint32_t nc;
+     if(!(getBinary(p,end,x) && getBinary(p,end,y) && getBinary(p,end,a) && getBinary(p,end,i) && getBinary(p,end,circularity) &&
+          getBinary(p,end,inertia) && getBinary(p,end,convexity) && getBinary(p,end,flag) && getBinary(p,end,nc)))
+      return false;
+     if((unsigned long)(end-p)<(unsigned long)nc*2*sizeof(int32_t))
+      return false;
+     vector<cv::Point> c(nc);
+     for(uint32_t k=0; k<nc; k++)
+     {
+      int32_t cx,cy;
+      getBinary(p,end,cx);
+      getBinary(p,end,cy);
+      c[k]=cv::Point(cx,cy);
+     }
+     frame.addMosquito(x,y,a,i,circularity,inertia,convexity,0,c);
+     frame.mosqi(frame.numOfMosquitoes()-1)->setFlag(flag);
+    }
+    return p==end;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef POSITIONBACKUP_hpp
+#define POSITIONBACKUP_hpp
+#include "MosquitoesInFrame.hpp"
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+// "SPB1" at the start of every binary backup file
+#define POSITIONBACKUPMAGIC 0x31425053
+#define POSITIONBACKUPVERSION 1
+// the file is flushed to disk after this many frames
+#define POSITIONBACKUPSYNCFRAMES 64
+// a record larger than this is treated as corrupt
+#define POSITIONBACKUPMAXRECORD (64*1024*1024)
+
+using namespace std;
+
+/**
+  * \brief Append-only binary backup of the positions found during segmentation
+  *
+  * Every processed frame is stored as one record (including frames without any
+  * position) consisting of its length, a CRC32 of the payload and the payload.
+  * Records are written in native byte order, the file is only meant to recover
+  * a crashed run on the same machine. When an existing backup is opened for
+  * appending, a torn or corrupt tail is cut off behind the last good record.
+  */
+class PositionBackup
+{
+public:
+    PositionBackup();
+    ~PositionBackup();
+    bool open(string filename, int syncFrames = POSITIONBACKUPSYNCFRAMES);
+    bool isOpen(){return file!=nullptr;};
+    bool append(MosquitoesInFrame* frame);
+    bool sync();
+    void close();
+    static bool isBackupFile(string filename);
+    static long read(string filename, vector<MosquitoesInFrame>& frames);
+    static long scan(string filename, long* validBytes = nullptr);
+private:
+    static void encode(MosquitoesInFrame* frame, vector<char>& b);
+    static bool decode(const char* data, size_t n, MosquitoesInFrame& frame);
+    FILE* file;
+    string name;
+    int syncEvery;
+    int unsynced;
+    vector<char> buffer;
+};
+#endif //POSITIONBACKUP_hpp
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "PositionJournal.hpp"
+#include <iostream>
+
+using namespace std;
+
+PositionJournal::PositionJournal()
+{
+    recording=true;
+    stepOpen=false;
+    overflowed=false;
+    storedPositions=0;
+}
+
+void PositionJournal::beginStep(unsigned long maxSteps)
+{
+    // a step without any change is no undo point
+    if(stepOpen && undoSteps.size()>0 && positionsOfStep(undoSteps.back())==0)
+     undoSteps.pop_back();
+    undoSteps.push_back(vector<positionDelta>());
+    stepOpen=true;
+    openFrames.clear();
+    overflowed=false;
+    compact(maxSteps);
+}
+
+positionDelta& PositionJournal::deltaOfFrame(unsigned long frame)
+{
+    // edits without a preceding beginStep() open a step of their own
+    if(!stepOpen)
+    {
+     undoSteps.push_back(vector<positionDelta>());
+     stepOpen=true;
+     openFrames.clear();
+    }
+    if(redoSteps.size()>0)
+    {
+     for(unsigned long i=0; i<redoSteps.size(); i++)
+      storedPositions-=positionsOfStep(redoSteps[i]);
+     redoSteps.clear();
+    }
+    vector<positionDelta> &step=undoSteps.back();
+    unordered_map<unsigned long, unsigned long>::iterator it=openFrames.find(frame);
+    if(it!=openFrames.end())
+     return step[it->second];
+    openFrames[frame]=step.size();
+    positionDelta d;
+    d.frame=frame;
+    step.push_back(d);
+    return step.back();
+}
+
+void PositionJournal::recordAdded(unsigned long frame, const MosquitoPosition& p)
+{
+    if(!recording || overflowed)
+     return;
+    deltaOfFrame(frame).added.push_back(p);
+    storedPositions++;
+    limit();
+}
+
+void PositionJournal::recordRemoved(unsigned long frame, const MosquitoPosition& p)
+{
+    if(!recording || overflowed)
+     return;
+    positionDelta &d=deltaOfFrame(frame);
+    // a position added in the same step simply disappears from the step
+    for(unsigned long i=0; i<d.added.size(); i++)
+     if(d.added[i].getSlot()==p.getSlot())
+     {
+      d.added.erase(d.added.begin()+i);
+      storedPositions--;
+      return;
+     }
+    d.removed.push_back(p);
+    storedPositions++;
+    limit();
+}
+
+vector<positionDelta> PositionJournal::popUndo()
+{
+    stepOpen=false;
+    openFrames.clear();
+    vector<positionDelta> step;
+    while(undoSteps.size()>0 && positionsOfStep(step)==0)
+    {
+     step.swap(undoSteps.back());
+     undoSteps.pop_back();
+    }
+    storedPositions-=positionsOfStep(step);
+    return step;
+}
+
+vector<positionDelta> PositionJournal::popRedo()
+{
+    vector<positionDelta> step;
+    if(redoSteps.size()>0)
+    {
+     step.swap(redoSteps.back());
+     redoSteps.pop_back();
+    }
+    storedPositions-=positionsOfStep(step);
+    return step;
+}
+
+void PositionJournal::pushUndo(vector<positionDelta> step)
+{
+    stepOpen=false;
+    openFrames.clear();
+    storedPositions+=positionsOfStep(step);
+    undoSteps.push_back(vector<positionDelta>());
+    undoSteps.back().swap(step);
+}
+
+void PositionJournal::pushRedo(vector<positionDelta> step)
+{
+    storedPositions+=positionsOfStep(step);
+    redoSteps.push_back(vector<positionDelta>());
+    redoSteps.back().swap(step);
+}
+
+void PositionJournal::clear()
+{
+    vector<vector<positionDelta> >().swap(undoSteps);
+    vector<vector<positionDelta> >().swap(redoSteps);
+    openFrames.clear();
+    stepOpen=false;
+    overflowed=false;
+    storedPositions=0;
+}
+
+void PositionJournal::compact(unsigned long maxSteps)
+{
+    // the open step is never dropped
+    unsigned long n=0;
+    while(n+1<undoSteps.size() && (undoSteps.size()-n>maxSteps || storedPositions>POSITIONJOURNALMAXPOSITIONS))
+    {
+     storedPositions-=positionsOfStep(undoSteps[n]);
+     n++;
+    }
+    if(n>0)
+    {
+     undoSteps.erase(undoSteps.begin(), undoSteps.begin()+n);
+     cerr<<"Dropped the "<<n<<" oldest undo steps of the positions\n";
+    }
+}
+
+void PositionJournal::limit()
+{
+    // the oldest closed steps go first
+    if(storedPositions<=POSITIONJOURNALMAXPOSITIONS)
+     return;
+    unsigned long n=0;
+    while(n+1<undoSteps.size() && storedPositions>POSITIONJOURNALMAXPOSITIONS)
+    {
+     storedPositions-=positionsOfStep(undoSteps[n]);
+     n++;
+    }
+    if(n>0)
+    {
+     undoSteps.erase(undoSteps.begin(), undoSteps.begin()+n);
+     cerr<<"Dropped the "<<n<<" oldest undo steps of the positions\n";
+    }
+    if(storedPositions<=POSITIONJOURNALMAXPOSITIONS)
+     return;
+    // the open step alone is too large, a part of it could only be undone
+    // half, so nothing is recorded until the next step and the history goes
+    clear();
+    overflowed=true;
+    cerr<<"The edit is too large to be undone, the undo history of the positions was cleared\n";
+}
+
+unsigned long PositionJournal::positionsOfStep(const vector<positionDelta>& step)
+{
+    unsigned long n=0;
+    for(unsigned long i=0; i<step.size(); i++)
+     n+=step[i].removed.size()+step[i].added.size();
+    return n;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef POSITIONJOURNAL_hpp
+#define POSITIONJOURNAL_hpp
+#include "MosquitoPosition.hpp"
+#include <vector>
+#include <unordered_map>
+
+// older steps are dropped when the journal holds more positions than this, an open step
+// that alone exceeds it clears the history and stops recording until the next step
+#define POSITIONJOURNALMAXPOSITIONS 2000000
+
+using namespace std;
+
+/**
+  * \brief Positions removed from and added to one frame during one undo step
+  */
+struct positionDelta {
+    unsigned long frame;
+    vector<MosquitoPosition> removed;
+    vector<MosquitoPosition> added;
+};
+
+/**
+  * \brief Undo/redo journal of the position edits of a MosquitoesInSeq
+  *
+  * The frames report every position they add or remove while recording is
+  * enabled, a step collects these changes per frame between two calls of
+  * beginStep(). Undoing a step re-inserts the removed positions by their slot
+  * and removes the added ones, so the memory used grows with the edits only.
+  */
+class PositionJournal
+{
+public:
+    PositionJournal();
+    void beginStep(unsigned long maxSteps);
+    void recordAdded(unsigned long frame, const MosquitoPosition& p);
+    void recordRemoved(unsigned long frame, const MosquitoPosition& p);
+    bool isRecording(){return recording;};
+    void setRecording(bool b){recording=b;};
+    bool canUndo(){return undoSteps.size()>0;};
+    bool canRedo(){return redoSteps.size()>0;};
+    vector<positionDelta> popUndo();
+    vector<positionDelta> popRedo();
+    void pushUndo(vector<positionDelta> step);
+    void pushRedo(vector<positionDelta> step);
+    void clear();
+private:
+    positionDelta& deltaOfFrame(unsigned long frame);
+    void compact(unsigned long maxSteps);
+    void limit();
+    unsigned long positionsOfStep(const vector<positionDelta>& step);
+    bool recording;
+    bool stepOpen;
+    // the open step exceeded the limit and was dropped
+    bool overflowed;
+    vector<vector<positionDelta> > undoSteps;
+    vector<vector<positionDelta> > redoSteps;
+    // delta of each frame in the open step
+    unordered_map<unsigned long, unsigned long> openFrames;
+    unsigned long storedPositions;
+};
+#endif //POSITIONJOURNAL_hpp
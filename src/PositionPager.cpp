@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "PositionPager.hpp"
+#include "Sidecar.hpp"
+#include <iostream>
+#include <atomic>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+PositionPager::PositionPager()
+{
+    budgetMB=0;
+    budget=0;
+    file=nullptr;
+    fileEnd=0;
+    lastBlock=(unsigned long)-1;
+    clock=0;
+    residentBytes=0;
+    residentBlocks=0;
+}
+
+PositionPager::PositionPager(const PositionPager& a)
+{
+    // a copy gets the same budget but a page file of its own
+    budgetMB=a.budgetMB;
+    budget=a.budget;
+    file=nullptr;
+    fileEnd=0;
+    lastBlock=(unsigned long)-1;
+    clock=0;
+    residentBytes=0;
+    residentBlocks=0;
+}
+
+PositionPager& PositionPager::operator=(const PositionPager& a)
+{
+    if(this!=&a)
+    {
+     reset();
+     budgetMB=a.budgetMB;
+     budget=a.budget;
+    }
+    return *this;
+}
+
+PositionPager::~PositionPager()
+{
+    closeFile();
+}
+
+bool PositionPager::setBudget(vector<MosquitoesInFrame>& frames, unsigned long MB, string filename /* = string() */)
+{
+    // the page file is the only copy of a block which cannot be read back
+    if(!loadAll(frames))
+     return false;
+    reset();
+    closeFile();
+    budgetMB=MB;
+    budget=MB*1024*1024;
+    name=filename;
+    if(budget==0)
+     return true;
+    if(!openFile())
+    {
+     budgetMB=0;
+     budget=0;
+     return false;
+    }
+    switchBlock(frames, 0);
+    return true;
+}
+
+bool PositionPager::loadAll(vector<MosquitoesInFrame>& frames)
+{
+    bool ok=true;
+    for(unsigned long b=0; b<blocks.size(); b++)
+     if(!blocks[b].resident && !pageIn(frames, b))
+      ok=false;
+    return ok;
+}
+
+void PositionPager::reset()
+{
+    // the frames were replaced, nothing on disk belongs to them any more
+    vector<pagedBlock>().swap(blocks);
+    lastBlock=(unsigned long)-1;
+    clock=0;
+    residentBytes=0;
+    residentBlocks=0;
+    fileEnd=0;
+}
+
+bool PositionPager::switchBlock(vector<MosquitoesInFrame>& frames, unsigned long b)
+{
+    // the block we leave was probably changed
+    if(lastBlock<blocks.size() && blocks[lastBlock].resident)
+     measure(frames, lastBlock);
+    unsigned long nBlocks=(frames.size()+POSITIONPAGERBLOCK-1)/POSITIONPAGERBLOCK;
+    while(blocks.size()<nBlocks)
+    {
+     pagedBlock n;
+     n.resident=true;
+     n.onDisk=false;
+     n.offset=0;
+     n.capacity=0;
+     n.length=0;
+     n.crc=0;
+     n.bytes=0;
+     n.lastUse=0;
+     blocks.push_back(n);
+     residentBlocks++;
+     measure(frames, blocks.size()-1);
+    }
+    if(b<blocks.size())
+    {
+     if(!blocks[b].resident && !pageIn(frames, b))
+     {
+      // tried again on the next access
+      lastBlock=(unsigned long)-1;
+      return false;
+     }
+     blocks[b].lastUse=++clock;
+    }
+    lastBlock=b;
+    enforce(frames);
+    return true;
+}
+
+void PositionPager::measure(vector<MosquitoesInFrame>& frames, unsigned long b)
+{
+    unsigned long m=0;
+    for(unsigned long i=b*POSITIONPAGERBLOCK; i<(b+1)*POSITIONPAGERBLOCK && i<frames.size(); i++)
+     m+=frames[i].positionMemory();
+    residentBytes+=m;
+    residentBytes-=blocks[b].bytes;
+    blocks[b].bytes=m;
+}
+
+void PositionPager::enforce(vector<MosquitoesInFrame>& frames)
+{
+    while(residentBytes>budget && residentBlocks>POSITIONPAGERMINBLOCKS)
+    {
+     unsigned long lru=blocks.size();
+     for(unsigned long b=0; b<blocks.size(); b++)
+      if(blocks[b].resident && b!=lastBlock && blocks[b].bytes>0 &&
+         (lru==blocks.size() || blocks[b].lastUse<blocks[lru].lastUse))
+       lru=b;
+     if(lru==blocks.size() || !pageOut(frames, lru))
+      break;
+    }
+}
+
+bool PositionPager::pageOut(vector<MosquitoesInFrame>& frames, unsigned long b)
+{
+    pagedBlock &p=blocks[b];
+    buffer.clear();
+    for(unsigned long i=b*POSITIONPAGERBLOCK; i<(b+1)*POSITIONPAGERBLOCK && i<frames.size(); i++)
+     frames[i].positionsToBinary(buffer);
+    uint32_t crc=Sidecar::crc32(buffer.data(), buffer.size());
+    // an unchanged block is still on disk
+    if(!(p.onDisk && p.length==buffer.size() && p.crc==crc))
+    {
+     if(!openFile())
+      return false;
+     long offset=p.offset;
+     if(!p.onDisk || p.capacity<buffer.size())
+      offset=fileEnd;
+     if(fseek(file, offset, SEEK_SET)!=0 || fwrite(buffer.data(), 1, buffer.size(), file)!=buffer.size())
+     {
+      cerr<<"Failed to write positions to the page file, keeping them in memory\n";
+      return false;
+     }
+     if(offset==fileEnd)
+     {
+      fileEnd+=buffer.size();
+      p.capacity=buffer.size();
+     }
+     p.offset=offset;
+     p.length=buffer.size();
+     p.crc=crc;
+     p.onDisk=true;
+    }
+    for(unsigned long i=b*POSITIONPAGERBLOCK; i<(b+1)*POSITIONPAGERBLOCK && i<frames.size(); i++)
+     frames[i].dropPositions();
+    p.resident=false;
+    residentBytes-=p.bytes;
+    p.bytes=0;
+    residentBlocks--;
+    return true;
+}
+
+bool PositionPager::pageIn(vector<MosquitoesInFrame>& frames, unsigned long b)
+{
+    pagedBlock &p=blocks[b];
+    buffer.resize(p.length);
+    bool ok=file && fseek(file, p.offset, SEEK_SET)==0 && fread(buffer.data(), 1, p.length, file)==p.length
+            && Sidecar::crc32(buffer.data(), p.length)==p.crc;
+    const char* data=buffer.data();
+    const char* end=data+p.length;
+    for(unsigned long i=b*POSITIONPAGERBLOCK; ok && i<(b+1)*POSITIONPAGERBLOCK && i<frames.size(); i++)
+     ok=frames[i].positionsFromBinary(data, end);
+    if(!ok)
+    {
+     // the block stays on disk and is never written back from the frames
+     cerr<<"Failed to read the positions of frames "<<b*POSITIONPAGERBLOCK<<" to "<<(b+1)*POSITIONPAGERBLOCK-1<<" from the page file\n";
+     for(unsigned long i=b*POSITIONPAGERBLOCK; i<(b+1)*POSITIONPAGERBLOCK && i<frames.size(); i++)
+      frames[i].dropPositions();
+     return false;
+    }
+    p.resident=true;
+    residentBlocks++;
+    measure(frames, b);
+    return true;
+}
+
+bool PositionPager::openFile()
+{
+    if(file)
+     return true;
+    if(name.empty())
+     file=tmpfile();
+    else
+    {
+     // every pager gets a file of its own, two pagers of the same sequence
+     // would otherwise overwrite each other's blocks
+     static atomic<unsigned long> instances(0);
+     fileName=name+"."+to_string(getpid())+"."+to_string(instances++);
+     file=fopen(fileName.c_str(),"w+b");
+    }
+    fileEnd=0;
+    if(!file)
+     cerr<<"Failed to open the page file for the positions\n";
+    return file!=nullptr;
+}
+
+void PositionPager::closeFile()
+{
+    if(file)
+    {
+     fclose(file);
+     file=nullptr;
+     if(!fileName.empty())
+      remove(fileName.c_str());
+     fileName.clear();
+    }
+    fileEnd=0;
+}
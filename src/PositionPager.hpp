@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef POSITIONPAGER_hpp
+#define POSITIONPAGER_hpp
+#include "MosquitoesInFrame.hpp"
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+// number of consecutive frames which are paged together
+#define POSITIONPAGERBLOCK 256
+// blocks which stay in memory regardless of the budget, so pointers to the
+// frames used last stay valid
+#define POSITIONPAGERMINBLOCKS 4
+
+using namespace std;
+
+/**
+  * \brief Block of frames handled by the PositionPager
+  */
+struct pagedBlock {
+    bool resident;
+    bool onDisk;
+    long offset;
+    unsigned long capacity;
+    unsigned long length;
+    uint32_t crc;
+    unsigned long bytes;
+    unsigned long lastUse;
+};
+
+/**
+  * \brief Keeps the positions of a MosquitoesInSeq within a memory budget
+  *
+  * Frames are grouped into blocks of POSITIONPAGERBLOCK frames. Once the
+  * positions of all blocks in memory exceed the budget, the positions of the
+  * least recently used blocks are written to a page file and dropped. The
+  * frames themselves (time stamps, frame numbers, ...) always stay in memory.
+  * A block is paged in again on its next access through touch(). A block which
+  * cannot be read back stays on disk and its frames stay empty, touch() then
+  * returns false. With a budget of 0 the pager does nothing.
+  */
+class PositionPager
+{
+public:
+    PositionPager();
+    PositionPager(const PositionPager& a);
+    PositionPager& operator=(const PositionPager& a);
+    ~PositionPager();
+    bool setBudget(vector<MosquitoesInFrame>& frames, unsigned long MB, string filename = string());
+    unsigned long getBudget(){return budgetMB;};
+    bool touch(vector<MosquitoesInFrame>& frames, unsigned long i)
+    {
+        if(budget==0 || i/POSITIONPAGERBLOCK==lastBlock)
+         return true;
+        return switchBlock(frames, i/POSITIONPAGERBLOCK);
+    };
+    bool loadAll(vector<MosquitoesInFrame>& frames);
+    void reset();
+    unsigned long residentMemory(){return residentBytes;};
+private:
+    bool switchBlock(vector<MosquitoesInFrame>& frames, unsigned long b);
+    void measure(vector<MosquitoesInFrame>& frames, unsigned long b);
+    bool pageOut(vector<MosquitoesInFrame>& frames, unsigned long b);
+    bool pageIn(vector<MosquitoesInFrame>& frames, unsigned long b);
+    void enforce(vector<MosquitoesInFrame>& frames);
+    bool openFile();
+    void closeFile();
+    unsigned long budgetMB;
+    unsigned long budget;
+    string name;
+    // the page file in use, name with a suffix unique to this pager
+    string fileName;
+    FILE* file;
+    long fileEnd;
+    vector<pagedBlock> blocks;
+    unsigned long lastBlock;
+    unsigned long clock;
+    unsigned long residentBytes;
+    unsigned long residentBlocks;
+    vector<char> buffer;
+};
+#endif //POSITIONPAGER_hpp
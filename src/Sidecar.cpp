@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Sidecar.hpp"
+#include "BinaryIO.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+bool Sidecar::save(string filename, string source, uint32_t magic, uint32_t version, const vector<char>& payload)
+{
+    uint64_t size;
+    int64_t mtime;
+    if(!sourceStamp(source, size, mtime))
+     return false;
+    vector<char> head;
+    putBinary<uint32_t>(head, magic);
+    putBinary<uint32_t>(head, version);
+    putBinary<uint64_t>(head, size);
+    putBinary<int64_t>(head, mtime);
+    uint32_t crc=crc32(payload.data(), payload.size(), crc32(head.data(), head.size()));
+    FILE* f=fopen(filename.c_str(),"wb");
+    if(!f)
+     return false;
+    bool ok=fwrite(head.data(), 1, head.size(), f)==head.size() &&
+            fwrite(payload.data(), 1, payload.size(), f)==payload.size() &&
+            fwrite(&crc, sizeof(uint32_t), 1, f)==1;
+    ok=fclose(f)==0 && ok;
+    if(!ok)
+     remove(filename.c_str());
+    return ok;
+}
+
+bool Sidecar::load(string filename, string source, uint32_t magic, uint32_t version, vector<char>& payload)
+{
+    // only a sidecar of the same, unchanged source is used
+    uint64_t size;
+    int64_t mtime;
+    if(!sourceStamp(source, size, mtime))
+     return false;
+    FILE* f=fopen(filename.c_str(),"rb");
+    if(!f)
+     return false;
+    char head[2*sizeof(uint32_t)+sizeof(uint64_t)+sizeof(int64_t)];
+    bool ok=fread(head, 1, sizeof(head), f)==sizeof(head);
+    payload.clear();
+    char chunk[65536];
+    size_t r;
+    while(ok && (r=fread(chunk, 1, sizeof(chunk), f))>0)
+     payload.insert(payload.end(), chunk, chunk+r);
+    fclose(f);
+    if(!ok || payload.size()<sizeof(uint32_t))
+     return false;
+    uint32_t crc;
+    memcpy(&crc, payload.data()+payload.size()-sizeof(uint32_t), sizeof(uint32_t));
+    payload.resize(payload.size()-sizeof(uint32_t));
+    if(crc32(payload.data(), payload.size(), crc32(head, sizeof(head)))!=crc)
+     return false;
+    const char* p=head;
+    const char* end=head+sizeof(head);
+    uint32_t fmagic, fversion;
+    uint64_t fsize;
+    int64_t fmtime;
+    getBinary(p,end,fmagic);
+    getBinary(p,end,fversion);
+    getBinary(p,end,fsize);
+    getBinary(p,end,fmtime);
+    return fmagic==magic && fversion==version && fsize==size && fmtime==mtime;
+}
+
+bool Sidecar::sourceStamp(string source, uint64_t& size, int64_t& mtime)
+{
+    struct stat st;
+    if(stat(source.c_str(), &st)!=0)
+     return false;
+    size=st.st_size;
+    mtime=st.st_mtime;
+    return true;
+}
+
+/**
+  * \brief Lookup table of the CRC32 polynomial
+  */
+struct crcTable {
+    uint32_t v[256];
+    crcTable()
+    {
+     for(uint32_t i=0; i<256; i++)
+     {
+      uint32_t c=i;
+      for(int k=0; k<8; k++)
+       c=(c&1)?0xEDB88320u^(c>>1):c>>1;
+      v[i]=c;
+     }
+    }
+};
+
+uint32_t Sidecar::crc32(const char* data, size_t n, uint32_t crc /* = 0 */)
+{
+    // built once, also when readers of several threads get here first
+    static const crcTable table;
+    crc=~crc;
+    for(size_t i=0; i<n; i++)
+     crc=table.v[(crc^(unsigned char)data[i])&0xff]^(crc>>8);
+    return ~crc;
+}
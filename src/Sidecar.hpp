@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SIDECAR_hpp
+#define SIDECAR_hpp
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+using namespace std;
+
+/**
+  * \brief Files stored next to a sequence or video which are derived from it
+  *
+  * A sidecar starts with its magic, its version and the size and modification
+  * time of the file it was made from, followed by the payload and a CRC32 of
+  * everything before it. A sidecar is only loaded while its source is unchanged.
+  */
+class Sidecar
+{
+public:
+    static bool save(string filename, string source, uint32_t magic, uint32_t version, const vector<char>& payload);
+    static bool load(string filename, string source, uint32_t magic, uint32_t version, vector<char>& payload);
+    static bool sourceStamp(string source, uint64_t& size, int64_t& mtime);
+    static uint32_t crc32(const char* data, size_t n, uint32_t crc = 0);
+};
+#endif //SIDECAR_hpp
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TimestampTable.hpp"
+#include "Sidecar.hpp"
+#include "BinaryIO.hpp"
+#include <string.h>
+
+using namespace std;
+
+TimestampTable::TimestampTable()
+{
+}
+
+void TimestampTable::clear()
+{
+    vector<int32_t>().swap(sec);
+    vector<uint32_t>().swap(ticks);
+}
+
+void TimestampTable::resize(unsigned long n)
+{
+    sec.resize(n,0);
+    ticks.resize(n,TIMESTAMPTABLENONE);
+}
+
+void TimestampTable::set(unsigned long i, int s, unsigned short ms, unsigned short us)
+{
+    if(i>=ticks.size())
+     resize(i+1);
+    sec[i]=s;
+    ticks[i]=ms*1000u+us;
+}
+
+vector<int> TimestampTable::at(unsigned long i)
+{
+    vector<int> t;
+    if(has(i))
+    {
+     t.push_back(sec[i]);
+     t.push_back(ticks[i]/1000);
+     t.push_back(ticks[i]%1000);
+    }
+    return t;
+}
+
+long TimestampTable::firstDecrease(unsigned long a, unsigned long e)
+{
+    // first frame in (a, e) which is older than the frame before it, or -1
+    if(e>ticks.size()) e=ticks.size();
+    for(unsigned long i=a+1; i<e; i++)
+     if(has(i) && has(i-1) && (sec[i]<sec[i-1] || (sec[i]==sec[i-1] && ticks[i]<ticks[i-1])))
+      return i;
+    return -1;
+}
+
+bool TimestampTable::save(string filename, string source)
+{
+    vector<char> b;
+    putBinary<uint64_t>(b, ticks.size());
+    unsigned long head=b.size();
+    b.resize(head+ticks.size()*(sizeof(int32_t)+sizeof(uint32_t)));
+    if(ticks.size()>0)
+    {
+     memcpy(b.data()+head, sec.data(), sec.size()*sizeof(int32_t));
+     memcpy(b.data()+head+sec.size()*sizeof(int32_t), ticks.data(), ticks.size()*sizeof(uint32_t));
+    }
+    return Sidecar::save(filename, source, TIMESTAMPTABLEMAGIC, TIMESTAMPTABLEVERSION, b);
+}
+
+bool TimestampTable::load(string filename, string source, unsigned long n)
+{
+    // only a table of the same, unchanged sequence is used
+    vector<char> b;
+    if(!Sidecar::load(filename, source, TIMESTAMPTABLEMAGIC, TIMESTAMPTABLEVERSION, b))
+     return false;
+    const char* p=b.data();
+    const char* end=b.data()+b.size();
+    uint64_t frames;
+    if(!getBinary(p,end,frames) || frames!=n)
+     return false;
+    if((unsigned long)(end-p)!=frames*(sizeof(int32_t)+sizeof(uint32_t)))
+     return false;
+    sec.resize(frames);
+    ticks.resize(frames);
+    if(frames>0)
+    {
+     memcpy(sec.data(), p, frames*sizeof(int32_t));
+     memcpy(ticks.data(), p+frames*sizeof(int32_t), frames*sizeof(uint32_t));
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TIMESTAMPTABLE_hpp
+#define TIMESTAMPTABLE_hpp
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// "STS1" at the start of every time stamp sidecar
+#define TIMESTAMPTABLEMAGIC 0x31535453
+#define TIMESTAMPTABLEVERSION 1
+// sub second ticks of a frame without time stamp
+#define TIMESTAMPTABLENONE 0xFFFFFFFFu
+
+using namespace std;
+
+/**
+  * \brief Time stamps of all frames of a sequence
+  *
+  * Every frame takes the seconds and the sub second ticks (ms*1000+us). The
+  * table is stored next to the sequence, together with the size and
+  * modification time of the sequence, so it only has to be read from the
+  * sequence once.
+  */
+class TimestampTable
+{
+public:
+    TimestampTable();
+    void clear();
+    void resize(unsigned long n);
+    void set(unsigned long i, int s, unsigned short ms, unsigned short us);
+    bool has(unsigned long i){return i<ticks.size() && ticks[i]!=TIMESTAMPTABLENONE;};
+    int getSec(unsigned long i){return has(i)?sec[i]:0;};
+    unsigned short getMSec(unsigned long i){return has(i)?ticks[i]/1000:0;};
+    unsigned short getUSec(unsigned long i){return has(i)?ticks[i]%1000:0;};
+    vector<int> at(unsigned long i);
+    unsigned long size(){return ticks.size();};
+    long firstDecrease(unsigned long a, unsigned long e);
+    bool save(string filename, string source);
+    bool load(string filename, string source, unsigned long n);
+private:
+    vector<int32_t> sec;
+    vector<uint32_t> ticks;
+};
+#endif //TIMESTAMPTABLE_hpp
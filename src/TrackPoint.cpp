@@ -25,7 +25,7 @@ using namespace std;
 TrackPoint::TrackPoint(double ix, double iy, int iframe, int itsec, int itmsec, int itusec, 
                double iintensity, double iarea, double imaxDiff,
                double iminA, double imaxA, double ithreshold, double iminthreshold, int iith, 
-               MosquitoPosition* in /*= nullptr*/)
+               int islot /*= -1*/)
 {
     x=ix;
     y=iy;
@@ -41,8 +41,7 @@ TrackPoint::TrackPoint(double ix, double iy, int iframe, int itsec, int itmsec,
     th=ithreshold;
     minTh=iminthreshold;
     ith=iith;
-    if(in)
-     mosquitoPointer=in;
+    slot=islot;
     flag=0;
 }
 
@@ -62,7 +61,7 @@ TrackPoint::TrackPoint(const TrackPoint &other)
     th=other.th;
     minTh=other.minTh;
     ith=other.ith;
-    mosquitoPointer=other.mosquitoPointer;
+    slot=other.slot;
     flag=other.flag;
 }
 
@@ -73,20 +72,20 @@ int TrackPoint::move(int ofx, int ofy)
     return 0;
 }
 
-bool TrackPoint::setMosquitoPointer(MosquitoPosition* in)
+bool TrackPoint::setSlot(int s)
 {
- if(in)
+ if(s>=0)
  {
-  mosquitoPointer=in;
+  slot=s;
   return true;
  }
  else
   return false;
 }
 
-MosquitoPosition* TrackPoint::getMosquitoPointer()
+int TrackPoint::getSlot()
 {
-  return mosquitoPointer;
+  return slot;
 }
 
 double TrackPoint::time()
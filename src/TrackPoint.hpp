@@ -31,28 +31,30 @@ public:
     TrackPoint(double ix, double iy, int iframe, int itsec, int itmsec, int itusec, 
                double iintensity, double iarea, double imaxDiff,
                double iminA, double imaxA, double ithreshold, double iminthreshold, int iith,
-               MosquitoPosition* in = nullptr);
+               int islot = -1);
     TrackPoint(const TrackPoint &other);
     int move(int ofx, int ofy);
     double time();
-    bool setMosquitoPointer(MosquitoPosition* in);
-    MosquitoPosition* getMosquitoPointer();
-    double x;
-    double y;
+    bool setSlot(int s);
+    int getSlot();
+    // kept small, registries hold millions of points; frame and position first
+    // as they are read by every scan over a track
     int frame;
+    float x;
+    float y;
     int tsec;
-    int tmsec;
-    int tusec;
-    double intensity;
-    double area;
-    double maxDiff;
-    double minA;
-    double maxA;
-    double th;
-    double minTh;
-    int ith;
-    MosquitoPosition* mosquitoPointer;
-    int flag;
-    
+    unsigned short tmsec;
+    unsigned short tusec;
+    float intensity;
+    float area;
+    float maxDiff;
+    float minA;
+    float maxA;
+    float th;
+    float minTh;
+    short ith;
+    short flag;
+    // slot of the linked MosquitoPosition in its frame, -1 if not linked yet
+    int slot;
 };
 #endif //TRACKPOINT_hpp
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "VideoIngest.hpp"
+#include "MyVideoReader.hpp"
+#include "oSeq.hpp"
+#include "Metadata.hpp"
+#include "Image.hpp"
+#include "Sidecar.hpp"
+#include "BinaryIO.hpp"
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+string VideoIngest::cacheName(string video)
+{
+    return video+".ingest.seq";
+}
+
+string VideoIngest::stampName(string video)
+{
+    return cacheName(video)+".stamp";
+}
+
+bool VideoIngest::saveStamp(string video, uint64_t frames)
+{
+    uint64_t csize;
+    int64_t cmtime;
+    if(!Sidecar::sourceStamp(cacheName(video), csize, cmtime))
+     return false;
+    vector<char> b;
+    putBinary<uint64_t>(b, csize);
+    putBinary<uint64_t>(b, frames);
+    return Sidecar::save(stampName(video), video, VIDEOINGESTMAGIC, VIDEOINGESTVERSION, b);
+}
+
+bool VideoIngest::valid(string video)
+{
+    // only a complete copy of the same, unchanged video is used
+    uint64_t csize;
+    int64_t cmtime;
+    if(!Sidecar::sourceStamp(cacheName(video), csize, cmtime))
+     return false;
+    vector<char> b;
+    if(!Sidecar::load(stampName(video), video, VIDEOINGESTMAGIC, VIDEOINGESTVERSION, b))
+     return false;
+    const char* p=b.data();
+    const char* end=b.data()+b.size();
+    uint64_t fcsize, frames;
+    if(!(getBinary(p,end,fcsize) && getBinary(p,end,frames)))
+     return false;
+    return p==end && fcsize==csize && frames>0;
+}
+
+bool VideoIngest::discard(string video)
+{
+    bool a=::remove(stampName(video).c_str())==0;
+    bool b=::remove(cacheName(video).c_str())==0;
+    return a || b;
+}
+
+int VideoIngest::ingest(string video, function<bool(unsigned long, unsigned long)> progress /*=nullptr*/)
+{
+    // the same frames and time stamps iSeq shows for the video
+    MyVideoReader reader;
+    reader.setFrameCache(0);
+    if(reader.open(video)!=1)
+    {
+     cerr<<"Could not open "<<video<<" for ingesting\n";
+     return 1;
+    }
+    unsigned long n=reader.get_total_frames();
+    Metadata meta;
+    bool haveMeta=false;
+    string mname=video+".metadata";
+    ifstream fm(mname.c_str());
+    if(fm.good())
+    {
+     fm.close();
+     meta.setInMemory(1);
+     meta.load(mname);
+     haveMeta=meta.getNo()==n && meta.timeIncluded();
+    }
+    discard(video);
+    // written under another name first, an interrupted ingest is never mistaken for a copy
+    string part=cacheName(video)+".part";
+    ::remove(part.c_str());
+    int status=0;
+    unsigned long i=0;
+    {
+     oSeq out;
+     out.open(part);
+     out.setFramerate(reader.get_fps());
+     Image<unsigned char> img;
+     reader.seek(0);
+     for(; i<n; i++)
+     {
+      if(reader.getNext(img))
+      {
+       // the frame count of mkv and other streams without one is estimated
+       // from the duration, the stream may well end before it
+       if(i==0)
+       {
+        cerr<<"Error reading the first frame of "<<video<<"!\n";
+        status=1;
+       }
+       else
+        cerr<<"The stream of "<<video<<" ends after "<<i<<" of an estimated "<<n<<" frames\n";
+       break;
+      }
+      if(haveMeta)
+      {
+       vector<int> t=meta.getT(i);
+       if(t.size()==3)
+       {
+        img.setTsec(t[0]);
+        img.setTmsec(t[1]);
+        img.setTusec(t[2]);
+       }
+      }
+      out.saveImage(&img);
+      if(progress && !progress(i+1, n))
+      {
+       status=1;
+       break;
+      }
+     }
+     out.close();
+    }
+    if(status==0 && rename(part.c_str(), cacheName(video).c_str())!=0)
+     status=1;
+    if(status==0 && !saveStamp(video, i))
+     status=1;
+    if(status!=0)
+    {
+     ::remove(part.c_str());
+     discard(video);
+     return 1;
+    }
+    cerr<<"Have ingested "<<i<<" frames of "<<video<<" into "<<cacheName(video)<<"\n";
+    return 0;
+}
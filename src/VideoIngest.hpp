@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020 Christian Kröner, University of Warwick
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VIDEOINGEST_hpp
+#define VIDEOINGEST_hpp
+#include <string>
+#include <functional>
+#include <stdint.h>
+
+// "VIN1" at the start of every ingest stamp
+#define VIDEOINGESTMAGIC 0x314E4956
+#define VIDEOINGESTVERSION 1
+
+using namespace std;
+
+/**
+  * \brief Raw copy of a video, decoded once into a seq file
+  *
+  * The frames of a video are written with their time stamps to a seq file
+  * next to it. A stamp holds the size and modification time of the video and
+  * the size of the copy, so iSeq only reads the copy of the same, unchanged
+  * video instead of decoding it again.
+  */
+class VideoIngest
+{
+public:
+    static string cacheName(string video);
+    static string stampName(string video);
+    static bool valid(string video);
+    static int ingest(string video, function<bool(unsigned long, unsigned long)> progress = nullptr);
+    static bool discard(string video);
+private:
+    static bool saveStamp(string video, uint64_t frames);
+};
+#endif //VIDEOINGEST_hpp
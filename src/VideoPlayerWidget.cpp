@@ -79,6 +79,12 @@ VideoPlayerWidget::VideoPlayerWidget()
     for(int n=0; n<4; n++)
      for(int m=0; m<4; m++)
       isOpen[n][m]=false;
+    for(int n=0; n<4; n++)
+     for(int m=0; m<4; m++)
+     {
+      previewFactor[n][m]=1;
+      previewed[n][m]=-1;
+     }
     pslider->setObjectName(QStringLiteral("pslider"));
     pslider->setOrientation(Qt::Horizontal);
 
@@ -396,6 +402,7 @@ if(isOpen[0][0])
       {
        seq[0][0]->setRequired(originalEachN);
       }
+      showFullFrames();
     }
 }
 }
@@ -480,6 +487,7 @@ void VideoPlayerWidget::timerEvent(QTimerEvent *event)
         timerID=-1;
         if(pskip!=0) 
          seq[0][0]->setRequired(originalEachN);
+        showFullFrames();
     }
 }
 
@@ -1319,10 +1327,29 @@ void VideoPlayerWidget::showFrame(int c, int r, bool random /*=false*/,bool colo
         if(frame[c][r]<seq[c][r]->allocatedFrames())
         {
             int status=0;
+            cv::Mat A;
+            bool preview=previewFactor[c][r]>1 && timerID!=-1 && !seq[c][r]->isImage();
+            if(preview)
+            {
+                // the reduced frame is blown up again, so points, zoom and roi still fit
+                cv::Mat p=seq[c][r]->previewImage(frame[c][r],previewFactor[c][r]);
+                if(p.empty())
+                    status=1;
+                else
+                {
+                    cv::resize(p,A,cv::Size(seq[c][r]->pointerToHeader()->width(),seq[c][r]->pointerToHeader()->height()),0,0,cv::INTER_NEAREST);
+                    previewed[c][r]=frame[c][r];
+                }
+            }
+            else
+            {
             if(seq[c][r]->currentFrame()!=frame[c][r] || frame[c][r]==0 || frame[c][r]==seq[c][r]->allocatedFrames()-1 || forceLoad==1 || seq[c][r]->isImage() ){
                 status=seq[c][r]->loadImage(frame[c][r]);
                 forceLoad=0;
             }
+            A=seq[c][r]->image(0,0);
+            previewed[c][r]=-1;
+            }
             if(status==0)
             {
             if(have_positions[c][r])
@@ -1330,29 +1357,33 @@ void VideoPlayerWidget::showFrame(int c, int r, bool random /*=false*/,bool colo
                 if(have_tracks[c][r])
                 {
                     OpenCVViewer[c][r]->setMinTrackL(minTrackL);
-                    OpenCVViewer[c][r]->showImageWithPointsAndTracks(seq[c][r]->image(0,0),MosqInSeq[c][r]->getAllPos(frame[c][r],metaMode),currReg[c][r]->getAllTracks(frame[c][r],trackL,minTrackL),
+                    OpenCVViewer[c][r]->showImageWithPointsAndTracks(A,MosqInSeq[c][r]->getAllPos(frame[c][r],metaMode),currReg[c][r]->getAllTracks(frame[c][r],trackL,minTrackL),
                                                                      MosqInSeq[c][r]->getPointMeta(frame[c][r],metaMode),currReg[c][r]->getTrackMeta(frame[c][r],trackL,minTrackL,random,colorByFlag),MosqInSeq[c][r]->getContours(frame[c][r],0,metaMode));
                 }
                 else
-                    OpenCVViewer[c][r]->showImageWithPoints(seq[c][r]->image(0,0),MosqInSeq[c][r]->getAllPos(frame[c][r],metaMode),MosqInSeq[c][r]->getPointMeta(frame[c][r],metaMode),MosqInSeq[c][r]->getContours(frame[c][r],0,metaMode));
-                if(c==0 && r==0)
-                {
-                TSec=seq[c][r]->getImagePointer(0)->getTsec();
-                TMSec=seq[c][r]->getImagePointer(0)->getTmsec();
-                TUSec=seq[c][r]->getImagePointer(0)->getTusec();
-                update_time();
-                }
+                    OpenCVViewer[c][r]->showImageWithPoints(A,MosqInSeq[c][r]->getAllPos(frame[c][r],metaMode),MosqInSeq[c][r]->getPointMeta(frame[c][r],metaMode),MosqInSeq[c][r]->getContours(frame[c][r],0,metaMode));
             }
             else
+                OpenCVViewer[c][r]->showImage(A);
+            if(c==0 && r==0)
             {
-                OpenCVViewer[c][r]->showImage(seq[c][r]->image(0,0) );
-                if(c==0 && r==0)
+                if(preview)
                 {
-                TSec=seq[c][r]->getImagePointer(0)->getTsec();
-                TMSec=seq[c][r]->getImagePointer(0)->getTmsec();
-                TUSec=seq[c][r]->getImagePointer(0)->getTusec();
-                update_time();
+                    vector<int> t=seq[c][r]->timeOfFrameI(frame[c][r]);
+                    if(t.size()==3)
+                    {
+                        TSec=t[0];
+                        TMSec=t[1];
+                        TUSec=t[2];
+                    }
                 }
+                else
+                {
+                    TSec=seq[c][r]->getImagePointer(0)->getTsec();
+                    TMSec=seq[c][r]->getImagePointer(0)->getTmsec();
+                    TUSec=seq[c][r]->getImagePointer(0)->getTusec();
+                }
+                update_time();
             }
             }
             else
@@ -1362,6 +1393,33 @@ void VideoPlayerWidget::showFrame(int c, int r, bool random /*=false*/,bool colo
         }
 }
 
+void VideoPlayerWidget::showFullFrames()
+{
+    // views which were played reduced show their last frame in full again
+    for(int c=0;c<vw;c++)
+     for(int r=0;r<vh; r++)
+      if(isOpen[c][r] && previewed[c][r]>=0)
+      {
+          unsigned long f=frame[c][r];
+          frame[c][r]=previewed[c][r];
+          showFrame(c,r);
+          frame[c][r]=f;
+      }
+}
+
+void VideoPlayerWidget::setPreview(int c, int r, int factor)
+{
+   if(c>=0 && c<4 && r>=0 && r<4)
+    previewFactor[c][r]=factor<1?1:factor;
+}
+
+int VideoPlayerWidget::getPreview(int c, int r)
+{
+   if(c>=0 && c<4 && r>=0 && r<4)
+    return previewFactor[c][r];
+   return 1;
+}
+
 iSeq* VideoPlayerWidget::getSeqPointer(int c, int r)
 {
    if(c>=0 && c<vw && r>=0 && r<vh)
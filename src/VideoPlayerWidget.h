@@ -27,6 +27,9 @@
 #include "Viewer.h"
 #include <QGridLayout>
 #include <QMouseEvent>
+
+// shrink factor of preview frames, shown during playback of views with preview decoding
+#define PLAYERPREVIEWFACTOR 4
 class Viewer;
 class QPushButton;
 class QLabel;
@@ -122,6 +125,8 @@ public slots:
     void setColumns(int x);
     void setRows(int y);
     void activateMetaMode(bool b);
+    void setPreview(int c, int r, int factor);
+    int getPreview(int c, int r);
     void setZoom(QPoint m, int c, int r, int dx, int dy);
     void setZoom(int c, int r, int ix, int iy, int iw, int ih);
     void setROI(QPoint m, int c, int r, int dx, int dy);
@@ -149,6 +154,7 @@ protected:
 private:
     int switchMeta();
     void showFrame(int c, int r, bool random = false, bool colorByFlag = false);
+    void showFullFrames();
     int getPreviousTrigger();
     int getNextTrigger();
     QPushButton *firstButton, *lastButton, *prevButton, *nextButton, *playButton, *loopButton, *stopButton;
@@ -171,6 +177,10 @@ private:
     int trackL;
     int minTrackL;
     bool isOpen[4][4];
+    // 1 shows full frames, larger values reduced ones while playing
+    int previewFactor[4][4];
+    // frame shown reduced last, -1 if the view shows a full frame
+    long previewed[4][4];
     unsigned long frame[4][4];
     int timerID;
     int playing;
@@ -70,7 +70,7 @@ iSeq::iSeq()
     thisFrame=0;
     has_buffer=1;
     haveBackupFile=0;
-    backupInterval=1;
+    backupInterval=POSITIONBACKUPSYNCFRAMES;
     have_meta=0;
     isVid=0;
     isImg=0;
@@ -82,6 +82,17 @@ iSeq::iSeq()
     roi.width=0;
     roi.height=0;
     hasPolyRoi=false;
+    haveTimestamps=false;
+    timestampBlocksRead=0;
+    videoThreads=VIDEODECODETHREADS;
+    videoThreadType=VIDEODECODETHREADTYPE;
+    videoDecodeAhead=VIDEODECODEAHEAD;
+    videoCacheMB=VIDEOFRAMECACHEMB;
+    previewVid=nullptr;
+    previewFactor=0;
+    previewFrame=-1;
+    useIngested=true;
+    ingested=false;
 }
 
 iSeq::~iSeq()
@@ -101,6 +112,8 @@ if(seqFile != nullptr)
 if(isVid==1)
  if(vid != nullptr)
   delete vid;
+closePreview();
+closeBackupFile();
 }
 
 iSeq::iSeq(iSeq&& other)
@@ -126,15 +139,32 @@ iSeq::iSeq(iSeq&& other)
     other.seqFile=nullptr;
     isVid=other.isVid;
     isImg=other.isImg;
+    videoThreads=other.videoThreads;
+    videoThreadType=other.videoThreadType;
+    videoDecodeAhead=other.videoDecodeAhead;
+    videoCacheMB=other.videoCacheMB;
+    useIngested=other.useIngested;
+    ingested=other.ingested;
+    previewVid=nullptr;
+    previewFactor=0;
+    previewFrame=-1;
     for(unsigned i=0;i<other.requiredImages;i++) other.InMemory[i].hasNoBuffer();
     for(unsigned i=0;i<other.nWorkImages;i++) other.DoubleWorkImages[i].hasNoBuffer();
     for(unsigned i=0;i<other.nShortImages;i++) other.ShortWorkImages[i].hasNoBuffer();
     haveBackupFile=other.haveBackupFile;
+    backupFile=other.backupFile;
+    other.haveBackupFile=0;
     backupInterval=other.backupInterval;
     have_meta=other.have_meta;
     if(have_meta) loadMeta();
+    timestamps=other.timestamps;
+    haveTimestamps=other.haveTimestamps;
+    timestampBlocks=other.timestampBlocks;
+    timestampBlocksRead=other.timestampBlocksRead;
     if(isVid) {
     vid=new MyVideoReader();
+    vid->setDecoding(videoThreads, videoThreadType, videoDecodeAhead);
+    vid->setFrameCache(videoCacheMB);
     vid->open(seqfilename);    
     }
     hasRoi=other.hasRoi;
@@ -175,12 +205,27 @@ iSeq& iSeq::operator=(iSeq&& other)
     nextImage=other.nextImage;
     thisFrame=other.thisFrame;
     seqFile=other.seqFile;
+    closeBackupFile();
     haveBackupFile=other.haveBackupFile;
+    backupFile=other.backupFile;
+    other.haveBackupFile=0;
     backupInterval=other.backupInterval;
     have_meta=other.have_meta;
     if(have_meta) loadMeta();
+    timestamps=other.timestamps;
+    haveTimestamps=other.haveTimestamps;
+    timestampBlocks=other.timestampBlocks;
+    timestampBlocksRead=other.timestampBlocksRead;
     isVid=other.isVid;
     isImg=other.isImg;
+    videoThreads=other.videoThreads;
+    videoThreadType=other.videoThreadType;
+    videoDecodeAhead=other.videoDecodeAhead;
+    videoCacheMB=other.videoCacheMB;
+    useIngested=other.useIngested;
+    ingested=other.ingested;
+    closePreview();
+    other.closePreview();
     if(other.isVid) other.vid->release();
     if(isVid) vid->open(seqfilename);    
     has_buffer=1;
@@ -206,6 +251,11 @@ int iSeq::open(string filename)
 {
     seqFile=new fstream;
     seqfilename=filename;
+    closePreview();
+    timestamps.clear();
+    haveTimestamps=false;
+    timestampBlocks.clear();
+    timestampBlocksRead=0;
     seqFile->open(filename.c_str(),ios::binary|ios::in);
     int status=0;
     if(seqFile->is_open())
@@ -216,7 +266,26 @@ int iSeq::open(string filename)
            seqFile->close();
            if(has_suffix(filename,".mp4") || has_suffix(filename,".mkv") || has_suffix(filename,".avi"))
            {
+           ingested=false;
+           if(useIngested && VideoIngest::valid(filename))
+           {
+              // the raw copy is read like any seq file, all other files keep the name of the video
+              seqFile->open(VideoIngest::cacheName(filename).c_str(),ios::binary|ios::in);
+              if(seqFile->is_open())
+                 status=header.ReadHeader(seqFile);
+              if(status==0)
+              {
+                 cerr<<"Reading "<<filename<<" from "<<VideoIngest::cacheName(filename)<<endl;
+                 ingested=true;
+              }
+              else
+                 seqFile->close();
+           }
+           if(!ingested)
+           {
            vid=new MyVideoReader();
+           vid->setDecoding(videoThreads, videoThreadType, videoDecodeAhead);
+           vid->setFrameCache(videoCacheMB);
            status=vid->open(filename);
            if(status==1)
            {
@@ -237,6 +306,7 @@ int iSeq::open(string filename)
               status=1;
            }
            }
+           }
            else
            {
            img = cv::imread(filename, cv::IMREAD_GRAYSCALE);
@@ -273,6 +343,7 @@ int iSeq::open(string filename)
     else
     {
      loadMeta();     
+     initTimestamps();
      return 0;
     }
 }
@@ -506,32 +577,9 @@ vector<int>  iSeq::timeOfFrameI(unsigned long n)
 
     if(isVid==0 && n<header.allocatedFrames())
     {
-        if(seqFile)
-        {
-            seqFile->seekg(header.TimeStartOffset(n), seqFile->beg);
-            if(header.streampix6())
-            {
-                int sec;
-                unsigned short ms,us;
-                seqFile->read(reinterpret_cast<char*>(&sec), sizeof(int));
-                seqFile->read(reinterpret_cast<char*>(&ms), sizeof(unsigned short));
-                seqFile->read(reinterpret_cast<char*>(&us), sizeof(unsigned short));
-                tmp.push_back(sec);
-                tmp.push_back(ms);
-                tmp.push_back(us);
-            }
-            else
-            {
-                int sec;
-                unsigned short ms,us;
-                seqFile->read(reinterpret_cast<char*>(&sec), sizeof(int));
-                seqFile->read(reinterpret_cast<char*>(&ms), sizeof(unsigned short));
-                seqFile->read(reinterpret_cast<char*>(&us), sizeof(unsigned short));
-                tmp.push_back(sec);
-                tmp.push_back(ms);
-                tmp.push_back(us);
-            }
-        }
+        if(!haveTimestamps && !timestampBlocks[n/SEQTIMESTAMPBLOCK])
+         readTimestampBlock(n/SEQTIMESTAMPBLOCK);
+        tmp=timestamps.at(n);
     }
     else if(isVid && have_meta && n<header.allocatedFrames())
     {
@@ -551,6 +599,100 @@ vector<int>  iSeq::timeOfFrameI(unsigned long n)
   }
 }
 
+TimestampTable* iSeq::timestampTable()
+{
+    // reads every missing block, which also writes the sidecar, for users of all
+    // time stamps such as MosquitoesInSeq::fixTime(); single frames go through timeOfFrameI()
+    // videos and images take the time stamps from the metadata which is in memory anyway
+    if(!haveTimestamps)
+    {
+     if(!isImg && !isVid)
+     {
+      for(unsigned long b=0; b<timestampBlocks.size(); b++)
+       if(!timestampBlocks[b])
+        readTimestampBlock(b);
+     }
+     else
+     {
+      unsigned long n=header.allocatedFrames();
+      timestamps.clear();
+      timestamps.resize(n);
+      for(unsigned long i=0; i<n; i++)
+      {
+       vector<int> t=timeOfFrameI(i);
+       if(t.size()==3)
+        timestamps.set(i, t[0], t[1], t[2]);
+      }
+     }
+     haveTimestamps=true;
+    }
+    return &timestamps;
+}
+
+void iSeq::initTimestamps()
+{
+    // a seq file which was opened before brings its time stamps along,
+    // otherwise they are read block by block when they are needed
+    if(isImg || isVid)
+     return;
+    unsigned long n=header.allocatedFrames();
+    if(timestamps.load(timestampName(), seqfilename, n))
+    {
+     haveTimestamps=true;
+     return;
+    }
+    timestamps.clear();
+    timestamps.resize(n);
+    timestampBlocks.assign((n+SEQTIMESTAMPBLOCK-1)/SEQTIMESTAMPBLOCK, false);
+    timestampBlocksRead=0;
+}
+
+void iSeq::readTimestampBlock(unsigned long b)
+{
+    unsigned long n=header.allocatedFrames();
+    unsigned long first=b*SEQTIMESTAMPBLOCK;
+    unsigned long last=min(first+SEQTIMESTAMPBLOCK, n);
+    if(!seqFile || b>=timestampBlocks.size() || timestampBlocks[b])
+     return;
+    unsigned long stride=header.trueImageSize();
+    // small frames are read in one piece, otherwise each time stamp is read on its own
+    unsigned long perRead=1;
+    if(stride>0 && stride<=SEQTIMESTAMPMAXSTRIDE)
+     perRead=SEQTIMESTAMPCHUNK/stride;
+    const unsigned long tsSize=sizeof(int)+2*sizeof(unsigned short);
+    vector<char> buffer;
+    for(unsigned long i=first; i<last; i+=perRead)
+    {
+     unsigned long k=min(perRead, last-i);
+     buffer.resize((k-1)*stride+tsSize);
+     seqFile->clear();
+     seqFile->seekg(header.TimeStartOffset(i), seqFile->beg);
+     seqFile->read(buffer.data(), buffer.size());
+     unsigned long got=seqFile->gcount();
+     for(unsigned long j=0; j<k && j*stride+tsSize<=got; j++)
+     {
+      int sec;
+      unsigned short ms,us;
+      memcpy(&sec, buffer.data()+j*stride, sizeof(int));
+      memcpy(&ms, buffer.data()+j*stride+sizeof(int), sizeof(unsigned short));
+      memcpy(&us, buffer.data()+j*stride+sizeof(int)+sizeof(unsigned short), sizeof(unsigned short));
+      timestamps.set(i+j, sec, ms, us);
+     }
+    }
+    seqFile->clear();
+    timestampBlocks[b]=true;
+    timestampBlocksRead++;
+    long bad=timestamps.firstDecrease(first>0?first-1:0, last+1);
+    if(bad!=-1)
+     cerr<<"Time stamps of "<<seqfilename<<" go back in time at frame "<<bad<<"\n";
+    if(timestampBlocksRead==timestampBlocks.size())
+    {
+     haveTimestamps=true;
+     if(!timestamps.save(timestampName(), seqfilename))
+      cerr<<"Could not write the time stamps to "<<timestampName()<<"\n";
+    }
+}
+
 int iSeq::sec(unsigned long i)
 {
     if(i<requiredImages)
@@ -709,22 +851,39 @@ void iSeq::openBackupFile()
 {
     if(!haveBackupFile)
     {
-    backupFile=new ofstream;
     string bname=backupName();
-    backupFile->open(bname.c_str(),ios::binary|ios::app);
-    if(backupFile->is_open())
+    ifstream fb(bname.c_str());
+    if(fb.good() && !PositionBackup::isBackupFile(bname))
+    {
+       // text backups of older versions are kept next to the new one
+       fb.close();
+       string oname=bname+".txt";
+       cerr<< "Moving old text backup to "<<oname<<"\n";
+       rename(bname.c_str(),oname.c_str());
+    }
+    backupFile=new PositionBackup;
+    if(backupFile->open(bname,backupInterval))
     {
        haveBackupFile=1;
     }
     else
+    {
        cerr<< "Failed to open Backup File for writing\n";
+       delete backupFile;
     }
+    }
+}
+
+void iSeq::syncBackupFile()
+{
+    if(haveBackupFile)
+        backupFile->sync();
 }
 
 void iSeq::backupCurrentPositions(MosquitoesInFrame* currentFrame)
 {
     if(haveBackupFile)
-        currentFrame->appendToBackup(backupFile);
+        backupFile->append(currentFrame);
 }
 
 string iSeq::settingsName()
@@ -740,6 +899,20 @@ string iSeq::backupName()
     return bname;
 }
 
+string iSeq::pageName()
+{
+
+    string pname = seqfilename.substr(0, seqfilename.find_last_of("."))+"_pos.page";
+    return pname;
+}
+
+string iSeq::timestampName()
+{
+
+    string tname = seqfilename+".timestamps";
+    return tname;
+}
+
 string iSeq::metaName()
 {
 
@@ -929,6 +1102,125 @@ bool iSeq::setPolyRoi(vector<cv::Point> poly)
  return true;
 }
 
+void iSeq::setVideoDecoding(int threads, int type, int ahead)
+{
+ // used for the next video, an open video is reopened and its frames reloaded
+ videoThreads=threads;
+ videoThreadType=type;
+ videoDecodeAhead=ahead;
+ if(isVid==1 && vid->isOpened())
+ {
+  vid->setDecoding(threads, type, ahead);
+  reloadImages(thisFrame);
+ }
+}
+
+void iSeq::setVideoCache(unsigned long MB)
+{
+ videoCacheMB=MB;
+ if(isVid==1 && vid->isOpened())
+  vid->setFrameCache(MB);
+}
+
+void iSeq::closePreview()
+{
+ if(previewVid != nullptr)
+ {
+  delete previewVid;
+  previewVid=nullptr;
+ }
+ previewFactor=0;
+ previewFrame=-1;
+}
+
+Mat iSeq::previewImage(unsigned long i, int factor)
+{
+ // every factor-th pixel of every factor-th row, the frames in memory are not touched
+ Mat tmp;
+ if(factor<1)
+  factor=1;
+ if(i>=header.allocatedFrames())
+  return tmp;
+ if(isImg)
+ {
+  tmp=Mat((img.rows+factor-1)/factor, (img.cols+factor-1)/factor, CV_8UC1);
+  for(int y=0; y<tmp.rows; y++)
+   for(int x=0; x<tmp.cols; x++)
+    tmp.at<unsigned char>(y,x)=img.at<unsigned char>(y*factor,x*factor);
+  return tmp;
+ }
+ if(isVid==0)
+ {
+  if(seqFile==nullptr || !seqFile->is_open())
+   return tmp;
+  // only the rows which are shown are read from the seq file
+  unsigned int w=header.width();
+  unsigned int h=header.height();
+  tmp=Mat((h+factor-1)/factor, (w+factor-1)/factor, CV_8UC1);
+  previewRow.resize(w);
+  for(int y=0; y<tmp.rows; y++)
+  {
+   seqFile->seekg(header.imageStartOffset(i)+(unsigned long long)w*y*factor, seqFile->beg);
+   seqFile->read((char*)previewRow.data(), w);
+   if(!seqFile->good())
+   {
+    seqFile->clear();
+    cerr<<"Error reading preview of frame "<<i<<"!\n";
+    return Mat();
+   }
+   unsigned char* row=tmp.ptr<unsigned char>(y);
+   for(int x=0; x<tmp.cols; x++)
+    row[x]=previewRow[x*factor];
+  }
+  return tmp;
+ }
+ if(previewVid==nullptr || previewFactor!=factor)
+ {
+  // the decoder shrinks by powers of two as far as it can, the rest is subsampled
+  closePreview();
+  int lowres=0;
+  while(lowres<3 && (2<<lowres)<=factor)
+   lowres++;
+  previewVid=new MyVideoReader();
+  previewVid->setDecoding(videoThreads, videoThreadType, videoDecodeAhead);
+  previewVid->setFrameCache(0);
+  previewVid->setPreview(lowres);
+  if(previewVid->open(seqfilename)!=1)
+  {
+   cerr<<"Error opening preview of "<<seqfilename<<"!\n";
+   closePreview();
+   return tmp;
+  }
+  previewFactor=factor;
+ }
+ if(previewFrame<0 || (long)i<previewFrame || (long)i>previewFrame+SEQPREVIEWMAXSKIP)
+ {
+  previewVid->seek((int64_t)i);
+  previewFrame=(long)i-1;
+ }
+ for(; previewFrame<(long)i; previewFrame++)
+  if(previewVid->getNext(previewImg))
+  {
+   cerr<<"Error reading preview of frame "<<i<<"!\n";
+   previewFrame=-1;
+   return tmp;
+  }
+ // a decoder without reduced resolution leaves the whole factor to the stride
+ int step=(factor*previewVid->getW()+header.width()/2)/header.width();
+ if(step<1)
+  step=1;
+ Mat full=previewImg.image();
+ tmp=Mat((full.rows+step-1)/step, (full.cols+step-1)/step, CV_8UC1);
+ for(int y=0; y<tmp.rows; y++)
+ {
+  const unsigned char* src=full.ptr<unsigned char>(y*step);
+  unsigned char* row=tmp.ptr<unsigned char>(y);
+  for(int x=0; x<tmp.cols; x++)
+   row[x]=src[x*step];
+ }
+ return tmp;
+}
+
 //https://stackoverflow.com/questions/20446201/how-to-check-if-string-ends-with-txt
 bool iSeq::has_suffix(const std::string &str, const std::string &suffix)
 {
@@ -50,6 +50,17 @@
 #endif
 //end opencv
 #include "MosquitoesInFrame.hpp"
+#include "PositionBackup.hpp"
+#include "TimestampTable.hpp"
+#include "VideoIngest.hpp"
+
+// frames of a seq file whose time stamps are read together
+#define SEQTIMESTAMPBLOCK 1024
+// frames up to this size are read in one piece instead of seeking to every time stamp
+#define SEQTIMESTAMPMAXSTRIDE (64*1024)
+#define SEQTIMESTAMPCHUNK (4*1024*1024)
+// a preview which skips up to this many frames decodes through them instead of seeking
+#define SEQPREVIEWMAXSKIP 16
 using namespace std;
 
 /**
@@ -86,12 +97,16 @@ public:
     int setRequired(int n);
     int getRequired(){return requiredImages;};
     vector<int>  timeOfFrameI(unsigned long n);
+    TimestampTable* timestampTable();
     void openBackupFile();
     void closeBackupFile();
+    void syncBackupFile();
     void backupCurrentPositions(MosquitoesInFrame* currentFrame);
     string settingsName();
     string backupName();
+    string pageName();
     string metaName();
+    string timestampName();
     int hasMeta();
     int metaData(unsigned long i);
     int lookUpTrigger(unsigned int i);
@@ -102,6 +117,17 @@ public:
     bool gotPolyRoi();
     bool setRoi(int rx,int ry,int rw,int rh);
     bool setPolyRoi(vector<cv::Point> poly);
+    void setVideoDecoding(int threads, int type, int ahead);
+    int getVideoThreads(){return videoThreads;};
+    int getVideoThreadType(){return videoThreadType;};
+    int getVideoDecodeAhead(){return videoDecodeAhead;};
+    void setVideoCache(unsigned long MB);
+    unsigned long getVideoCache(){return videoCacheMB;};
+    cv::Mat previewImage(unsigned long i, int factor);
+    void setUseIngested(bool b){useIngested=b;};
+    bool getUseIngested(){return useIngested;};
+    bool isIngested(){return ingested;};
+    bool isVideo(){return isVid==1;};
 private:
     int loadMeta();
     Header header;
@@ -116,7 +142,7 @@ private:
     unsigned long nWorkImages;
     unsigned long nShortImages;
     fstream* seqFile;
-    ofstream* backupFile;
+    PositionBackup* backupFile;
     int haveBackupFile;
     int backupInterval;
     int* framePointer;
@@ -129,6 +155,26 @@ private:
     int have_meta;
     int isVid;
     MyVideoReader* vid;
+    int videoThreads;
+    int videoThreadType;
+    int videoDecodeAhead;
+    unsigned long videoCacheMB;
+    // a video with a valid ingested copy is read from the copy
+    bool useIngested;
+    bool ingested;
+    // second reader for preview frames, it leaves the frames in memory alone
+    MyVideoReader* previewVid;
+    int previewFactor;
+    long previewFrame;
+    Image<unsigned char> previewImg;
+    vector<unsigned char> previewRow;
+    void closePreview();
+    void initTimestamps();
+    void readTimestampBlock(unsigned long b);
+    TimestampTable timestamps;
+    bool haveTimestamps;
+    vector<bool> timestampBlocks;
+    unsigned long timestampBlocksRead;
     string positionFileName;
     string trackFileName;
     cv::Rect roi;
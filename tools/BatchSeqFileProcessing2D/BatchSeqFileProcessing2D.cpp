@@ -27,6 +27,8 @@
 #include <string>
 #include <unistd.h>
 #include "iSeq.hpp"
+#include "MosquitoesInFrame.hpp"
+#include "PositionBackup.hpp"
 
 //opencv
 #if CV_MAJOR_VERSION < 3
@@ -356,6 +358,29 @@ vector<vector<double> > process(Image<unsigned char>* a, Image<unsigned char>* b
 }
 
 
+void writeFrame(FILE* pFile, MosquitoesInFrame& frame)
+{
+ for(int i=0; i<frame.numOfMosquitoes(); i++)
+ {
+  MosquitoPosition* m=frame.mosqi(i);
+  fprintf(pFile,"%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\n",
+                m->getX(),
+                m->getY(),
+                m->getI(),
+                m->getA(),
+                frame.getMaxDiff(),
+                static_cast<double>(frame.getFrameNo()),
+                static_cast<double>(frame.getTsSec()),
+                static_cast<double>(frame.getTsMSec()),
+                static_cast<double>(frame.getTsUSec()));
+  vector<cv::Point> c=m->getContour();
+  fprintf(pFile,"#contour %u",c.size());
+  for(int cc=0; cc<c.size(); cc++)
+   fprintf(pFile," %i %i",c[cc].x,c[cc].y);
+  fprintf(pFile,"\n");
+ }
+}
+
 int main ( int argc, char *argv[])
 {
  if(argc==4 || argc==6 || argc==19 || argc==20 || argc==21)
@@ -380,6 +405,11 @@ int main ( int argc, char *argv[])
 
   int maskT=0;
   vector<cv::Point> poly;
+  int videoThreads=VIDEODECODETHREADS;
+  int videoThreadType=VIDEODECODETHREADTYPE;
+  int videoDecodeAhead=VIDEODECODEAHEAD;
+  // frames are read forward only, the scrubbing cache is of no use
+  int videoFrameCacheMB=0;
   
   if(argc==4 || argc==6)
   {
@@ -400,6 +430,10 @@ int main ( int argc, char *argv[])
    fs["gaussS2"] >> gaussS2;
    fs["maskT"] >> maskT;
    fs["polyRoiFilename"] >> polyRoiFilename;
+   if(!fs["videoDecodeThreads"].empty()) fs["videoDecodeThreads"] >> videoThreads;
+   if(!fs["videoDecodeThreadType"].empty()) fs["videoDecodeThreadType"] >> videoThreadType;
+   if(!fs["videoDecodeAhead"].empty()) fs["videoDecodeAhead"] >> videoDecodeAhead;
+   if(!fs["videoFrameCacheMB"].empty()) fs["videoFrameCacheMB"] >> videoFrameCacheMB;
    if( polyRoiFilename != string())
    {
     FileStorage fs( polyRoiFilename.c_str(), FileStorage::READ );
@@ -449,6 +483,8 @@ int main ( int argc, char *argv[])
   cerr<<"blackOnWhite="<<blackOnWhite<<"\n";
   cerr<<"useIth="<<useIth<<"\n";
   iSeq seq;
+  seq.setVideoDecoding(videoThreads, videoThreadType, videoDecodeAhead);
+  seq.setVideoCache(videoFrameCacheMB);
   char* sFile=argv[2];
   if(argc>6) sFile=argv[1];
   bool ret=seq.open(sFile);
@@ -488,7 +524,10 @@ int main ( int argc, char *argv[])
   FILE * pFile;
   char* oFile=argv[3];
   if(argc>6) oFile=argv[2];
-  if(!( access( oFile, F_OK ) != -1 ))
+  // binary backup of all frames written so far, an interrupted run resumes from it
+  string bFile=string(oFile)+".tmp";
+  bool resume=PositionBackup::isBackupFile(bFile);
+  if(!( access( oFile, F_OK ) != -1 ) || resume)
   {
    pFile = fopen (oFile,"w");
    if(pFile == NULL)
@@ -498,6 +537,20 @@ int main ( int argc, char *argv[])
    }
    else
    {
+    if(resume)
+    {
+     // the text output is rewritten from the good records of the backup
+     vector<MosquitoesInFrame> done;
+     long last=PositionBackup::read(bFile,done);
+     for(unsigned long i=0; i<done.size(); i++)
+      writeFrame(pFile,done[i]);
+     if(last>=0 && (unsigned long)last+1>start)
+      start=last+1;
+     cerr<<"Resuming from frame "<<start<<" with "<<done.size()<<" frames from "<<bFile<<"\n";
+    }
+    PositionBackup backup;
+    if(!backup.open(bFile))
+     cerr<<"Warning: I can't write the backup file "<<bFile<<"\n";
     if(start<stop && stop<=nFrames)
     {
      for( unsigned long n=start; n<stop; n++)
@@ -515,42 +568,42 @@ int main ( int argc, char *argv[])
        centers=process(seq.getImagePointer(0), seq.getImagePointer(useIth), minA, maxA,fracN,minThreshold,erode,dilute,blackOnWhite,
                        medianBlur1,medianBlur2,gaussK1,gaussS1,gaussK2,gaussS2,poly, maskT,false);
       }
+      MosquitoesInFrame frame;
+      frame.setFrameNo(n);
+      frame.setProcessed(1);
+      vector<int> t=seq.timeOfFrameI(n);
+      if(t.size()==3)
+       frame.setTime(t);
       if(centers.size()>1)
       {
        double maxDiff=centers[centers.size()-1][0];
-       for(unsigned long i=0; i<centers.size()-1; i++)
+       frame.setMaxDiff(maxDiff);
+       if(t.size()!=3)
+        cerr<<"ERROR: could not get time for frame....\n";
+       else
        {
-        vector<cv::Point> c;
-        for(unsigned long j=0; j<centers[i][8]; j++)
-         if(9+j*2+1<centers[i].size())
-        {
-          cv::Point tmp=cv::Point(centers[i][9+j*2],centers[i][9+j*2+1]);
-          c.push_back(tmp);
-        }
-        vector<int> t=seq.timeOfFrameI(n);
-        if(t.size()!=3)
-         cerr<<"ERROR: could not get time for frame....\n";
-        else
+        for(unsigned long i=0; i<centers.size()-1; i++)
         {
-         fprintf(pFile,"%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\t%.16f\n",
-                       centers[i][0],
-                       centers[i][1],
-                       centers[i][3],
-                       centers[i][2],
-                       maxDiff,
-                       static_cast<double>(n),
-                       static_cast<double>(t[0]),
-                       static_cast<double>(t[1]),
-                       static_cast<double>(t[2]));
-         fprintf(pFile,"#contour %u",c.size());
-         for(int cc=0; cc<c.size(); cc++)
-          fprintf(pFile," %i %i",c[cc].x,c[cc].y);
-         fprintf(pFile,"\n");
+         vector<cv::Point> c;
+         for(unsigned long j=0; j<centers[i][8]; j++)
+          if(9+j*2+1<centers[i].size())
+         {
+           cv::Point tmp=cv::Point(centers[i][9+j*2],centers[i][9+j*2+1]);
+           c.push_back(tmp);
+         }
+         frame.addMosquito(centers[i][0], centers[i][1], centers[i][2], centers[i][3],
+                           centers[i][4],centers[i][5],centers[i][6],centers[i][7],c);
         }
        }
       }
+      writeFrame(pFile,frame);
+      backup.append(&frame);
      }
     }
+    fclose(pFile);
+    // the text output is complete, the backup is not needed any more
+    backup.close();
+    remove(bFile.c_str());
    }
   }
   else
@@ -564,7 +617,8 @@ int main ( int argc, char *argv[])
       <<"       "<<argv[0]<<" iseq out.txt start stop minA maxA fracN \\\n"
       <<"minThreshold useIth erode dilute blackOnWhite medianBlur1 \\\n"
       <<"medianBlur2 gaussK1 gaussS1 gaussK2 gaussS2\\\n"
-      <<"[maskT] [poly.yml] \n";
+      <<"[maskT] [poly.yml] \n"
+      <<"An interrupted run is resumed from the backup out.txt.tmp\n";
  }
  return 0;
 }
@@ -6,6 +6,16 @@ SOURCES += BatchSeqFileProcessing2D.cpp \
            ../../src/MosquitoesInSeq.cpp \
            ../../src/MosquitoPosition.cpp \
            ../../src/MosquitoesInFrame.cpp \ 
+           ../../src/PositionJournal.cpp \
+           ../../src/PositionBackup.cpp \
+           ../../src/PositionPager.cpp \
+           ../../src/DetectionCounts.cpp \
+           ../../src/TimestampTable.cpp \
+           ../../src/Sidecar.cpp \
+           ../../src/KeyframeIndex.cpp \
+           ../../src/FrameCache.cpp \
+           ../../src/VideoIngest.cpp \
+           ../../src/oSeq.cpp \
            ../../src/iSeq.cpp \
            ../../src/Metadata.cpp \
            ../../src/MyVideoReader.cpp \
@@ -15,6 +25,17 @@ HEADERS  = ../../src/iSeq.hpp \
            ../../src/MosquitoesInSeq.hpp \
            ../../src/MosquitoPosition.hpp \
            ../../src/MosquitoesInFrame.hpp \ 
+           ../../src/PositionJournal.hpp \
+           ../../src/PositionBackup.hpp \
+           ../../src/PositionPager.hpp \
+           ../../src/DetectionCounts.hpp \
+           ../../src/TimestampTable.hpp \
+           ../../src/KeyframeIndex.hpp \
+           ../../src/FrameCache.hpp \
+           ../../src/VideoIngest.hpp \
+           ../../src/oSeq.hpp \
+           ../../src/BinaryIO.hpp \
+           ../../src/Sidecar.hpp \
            ../../src/Metadata.hpp \
            ../../src/MyVideoReader.hpp \
            ../../src/Header.hpp \
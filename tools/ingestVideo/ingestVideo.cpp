@@ -0,0 +1,69 @@
+/* 
+ * Copyright (C) 2020 Christian Kröner, University of Warwick 
+ *
+ * This file is part of SeqFileProcessing2D.
+ *
+ * SeqFileProcessing2D is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * SeqFileProcessing2D is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with SeqFileProcessing2D.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <string>
+#include <string.h>
+#include "VideoIngest.hpp"
+
+using namespace std;
+
+int main(int argc , char* argv[])  
+{
+ // videos are decoded once into a raw copy, later runs read the copy
+ bool force=false;
+ int first=1;
+ if(argc>1 && strcmp(argv[1],"-f")==0)
+ {
+  force=true;
+  first=2;
+ }
+ if(argc>first){
+  int failed=0;
+  for(int i=first; i<argc; i++)
+  {
+   string video=argv[i];
+   if(!force && VideoIngest::valid(video))
+   {
+    cerr<<video<<" is already ingested into "<<VideoIngest::cacheName(video)<<"\n";
+    continue;
+   }
+   unsigned long last=0;
+   int ret=VideoIngest::ingest(video,[&last](unsigned long done, unsigned long n){
+     if(done-last>=1000 || done==n)
+     {
+      cerr<<done<<"/"<<n<<" frames\r";
+      last=done;
+     }
+     return true;
+   });
+   cerr<<"\n";
+   if(ret!=0)
+   {
+    cerr<<"Error: Could not ingest "<<video<<"\n";
+    failed++;
+   }
+  }
+  return failed>0;
+ }
+ else{
+  cerr << "use:" << argv[0] <<" [-f] video [video ...]"<<endl;
+  cerr << "     -f ingests videos again which have a valid copy"<<endl;
+ }
+ return 0;
+}
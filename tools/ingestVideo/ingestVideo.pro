@@ -0,0 +1,73 @@
+QT       += core gui opengl
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TEMPLATE = app
+SOURCES += ingestVideo.cpp \
+           ../../src/MosquitoesInSeq.cpp \
+           ../../src/MosquitoPosition.cpp \
+           ../../src/MosquitoesInFrame.cpp \ 
+           ../../src/PositionJournal.cpp \
+           ../../src/PositionBackup.cpp \
+           ../../src/PositionPager.cpp \
+           ../../src/DetectionCounts.cpp \
+           ../../src/TimestampTable.cpp \
+           ../../src/Sidecar.cpp \
+           ../../src/KeyframeIndex.cpp \
+           ../../src/FrameCache.cpp \
+           ../../src/VideoIngest.cpp \
+           ../../src/iSeq.cpp \
+           ../../src/oSeq.cpp \
+           ../../src/Metadata.cpp \
+           ../../src/MyVideoReader.cpp \
+           ../../src/Header.cpp \
+           ../../src/Image.cpp
+
+HEADERS  = ../../src/iSeq.hpp \
+           ../../src/oSeq.hpp \
+           ../../src/MosquitoesInSeq.hpp \
+           ../../src/MosquitoPosition.hpp \
+           ../../src/MosquitoesInFrame.hpp \ 
+           ../../src/PositionJournal.hpp \
+           ../../src/PositionBackup.hpp \
+           ../../src/PositionPager.hpp \
+           ../../src/DetectionCounts.hpp \
+           ../../src/TimestampTable.hpp \
+           ../../src/KeyframeIndex.hpp \
+           ../../src/FrameCache.hpp \
+           ../../src/VideoIngest.hpp \
+           ../../src/BinaryIO.hpp \
+           ../../src/Sidecar.hpp \
+           ../../src/Metadata.hpp \
+           ../../src/MyVideoReader.hpp \
+           ../../src/Header.hpp \
+           ../../src/Image.hpp
+
+win32{
+}
+unix{
+target.path = /usr/local/bin
+INSTALLS += target
+}
+
+INCLUDEPATH += ../../src
+
+CONFIG += c++11
+CONFIG += console
+CONFIG += link_pkgconfig
+PKGCONFIG += opencv
+PKGCONFIG += libavdevice
+PKGCONFIG += libavformat
+PKGCONFIG += libavfilter
+PKGCONFIG += libavcodec
+PKGCONFIG += libswresample
+PKGCONFIG += libswscale
+PKGCONFIG += libavutil
+PKGCONFIG += icu-uc
+PKGCONFIG += icu-io
+
+QMAKE_CXXFLAGS += -fopenmp \
+                  -D_LARGEFILE64_SOURCE \
+                  -D_FILE_OFFSET_BITS=64 \
+                  -D__STDC_FORMAT_MACROS
+
+LIBS += -fopenmp
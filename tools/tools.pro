@@ -6,4 +6,5 @@ SUBDIRS = meta2txt \
           BatchSeqFileProcessing2D \
           GenerateTestSeq \
           comparePosFiles \
-          yuv2seq
+          yuv2seq \
+          ingestVideo
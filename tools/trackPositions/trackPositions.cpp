@@ -98,6 +98,11 @@ int main(int argc, char *argv[])
     if(ids[ii]==-1)
     {
      ids[ii]=Reg.registerNewMosquito();
+     if(ids[ii]==-1)
+     {
+      cerr<<"Error: the registry is full, no tracks written!\n";
+      return 1;
+     }
      starts++;
     }
     
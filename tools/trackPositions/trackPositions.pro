@@ -6,6 +6,16 @@ SOURCES += trackPositions.cpp \
            ../../src/MosquitoesInSeq.cpp \
            ../../src/MosquitoPosition.cpp \
            ../../src/MosquitoesInFrame.cpp \ 
+           ../../src/PositionJournal.cpp \
+           ../../src/PositionBackup.cpp \
+           ../../src/PositionPager.cpp \
+           ../../src/DetectionCounts.cpp \
+           ../../src/TimestampTable.cpp \
+           ../../src/Sidecar.cpp \
+           ../../src/KeyframeIndex.cpp \
+           ../../src/FrameCache.cpp \
+           ../../src/VideoIngest.cpp \
+           ../../src/oSeq.cpp \
            ../../src/MosquitoRegistry.cpp \
            ../../src/TrackPoint.cpp \
            ../../src/iSeq.cpp \
@@ -16,6 +26,17 @@ SOURCES += trackPositions.cpp \
 HEADERS  = ../../src/MosquitoesInSeq.hpp \
            ../../src/MosquitoPosition.hpp \
            ../../src/MosquitoesInFrame.hpp \ 
+           ../../src/PositionJournal.hpp \
+           ../../src/PositionBackup.hpp \
+           ../../src/PositionPager.hpp \
+           ../../src/DetectionCounts.hpp \
+           ../../src/TimestampTable.hpp \
+           ../../src/KeyframeIndex.hpp \
+           ../../src/FrameCache.hpp \
+           ../../src/VideoIngest.hpp \
+           ../../src/oSeq.hpp \
+           ../../src/BinaryIO.hpp \
+           ../../src/Sidecar.hpp \
            ../../src/MosquitoRegistry.hpp \
            ../../src/TrackPoint.hpp \
            ../../src/iSeq.hpp \
@@ -6,6 +6,15 @@ SOURCES += yuv2seq.cpp \
            ../../src/MosquitoesInSeq.cpp \
            ../../src/MosquitoPosition.cpp \
            ../../src/MosquitoesInFrame.cpp \ 
+           ../../src/PositionJournal.cpp \
+           ../../src/PositionBackup.cpp \
+           ../../src/PositionPager.cpp \
+           ../../src/DetectionCounts.cpp \
+           ../../src/TimestampTable.cpp \
+           ../../src/Sidecar.cpp \
+           ../../src/KeyframeIndex.cpp \
+           ../../src/FrameCache.cpp \
+           ../../src/VideoIngest.cpp \
            ../../src/iSeq.cpp \
            ../../src/oSeq.cpp \
            ../../src/Metadata.cpp \
@@ -18,6 +27,16 @@ HEADERS  = ../../src/iSeq.hpp \
            ../../src/MosquitoesInSeq.hpp \
            ../../src/MosquitoPosition.hpp \
            ../../src/MosquitoesInFrame.hpp \ 
+           ../../src/PositionJournal.hpp \
+           ../../src/PositionBackup.hpp \
+           ../../src/PositionPager.hpp \
+           ../../src/DetectionCounts.hpp \
+           ../../src/TimestampTable.hpp \
+           ../../src/KeyframeIndex.hpp \
+           ../../src/FrameCache.hpp \
+           ../../src/VideoIngest.hpp \
+           ../../src/BinaryIO.hpp \
+           ../../src/Sidecar.hpp \
            ../../src/Metadata.hpp \
            ../../src/MyVideoReader.hpp \
            ../../src/Header.hpp \